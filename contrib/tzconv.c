@@ -51,6 +51,9 @@
 
 /* see tzconv.m for details */
 
+/* number of stamps converted in one go */
+#define NCHUNK	(4096U)
+
 static zif_t
 find_zone(const mxArray *zstr)
 {
@@ -96,17 +99,30 @@ mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
 		plhs[0] = mxCreateDoubleMatrix(m, n, mxREAL);
 		tgt = mxGetPr(plhs[0]);
 
-		for (mwSize i = 0; i < m * n; i++) {
-			double x = TO_UNIX(src[i]);
+		/* convert in cache-sized chunks using the batch API */
+		for (mwSize i = 0; i < m * n; i += NCHUNK) {
+			const size_t nc = m * n - i < NCHUNK ? m * n - i : NCHUNK;
+			int64_t stmp[NCHUNK];
+			double frac[NCHUNK];
 
-			if (x < 2147483647.0 && x > -2147483648.0) {
-				double frac = modf(x, &x);
-				int32_t utc = zif_utc_time(fromz, (int32_t)x);
-				int32_t lcl = zif_local_time(toz, utc);
+			for (size_t j = 0U; j < nc; j++) {
+				double x = TO_UNIX(src[i + j]);
 
-				tgt[i] = TO_MATL((double)lcl) + frac / 86400.0;
-			} else {
-				tgt[i] = NAN;
+				/* stay within the exactly representable ints */
+				if (x < 9007199254740992.0 &&
+				    x > -9007199254740992.0) {
+					frac[j] = modf(x, &x);
+					stmp[j] = (int64_t)x;
+				} else {
+					frac[j] = NAN;
+					stmp[j] = 0;
+				}
+			}
+			zif_utc_time_v(fromz, stmp, stmp, nc);
+			zif_local_time_v(toz, stmp, stmp, nc);
+			for (size_t j = 0U; j < nc; j++) {
+				tgt[i + j] = TO_MATL((double)stmp[j]) +
+					frac[j] / 86400.0;
 			}
 		}
 	}
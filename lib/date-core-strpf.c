@@ -260,6 +260,7 @@ __strpd_card(struct strpd_s *d, const char *sp, struct dt_spec_s s, char **ep)
 		res = 0 - (d->c < 0);
 		break;
 	case DT_SPFL_S_WDAY:
+		dut_need_ilocale();
 		/* ymcw mode? */
 		switch (s.abbr) {
 		case DT_SPMOD_NORM:
@@ -288,6 +289,7 @@ __strpd_card(struct strpd_s *d, const char *sp, struct dt_spec_s s, char **ep)
 		res = 0 - (d->w < 0);
 		break;
 	case DT_SPFL_S_MON:
+		dut_need_ilocale();
 		switch (s.abbr) {
 		case DT_SPMOD_NORM:
 			d->m = strtoarri(
@@ -559,6 +561,7 @@ __strfd_card(
 		break;
 	}
 	case DT_SPFL_S_WDAY:
+		dut_need_flocale();
 		/* get the weekday in ymd mode!! */
 		d->w = d->w ? (dt_dow_t)d->w : dt_get_wday(that);
 		switch (s.abbr) {
@@ -584,6 +587,7 @@ __strfd_card(
 		}
 		break;
 	case DT_SPFL_S_MON:
+		dut_need_flocale();
 		switch (s.abbr) {
 		case DT_SPMOD_NORM:
 			res = arritostr(
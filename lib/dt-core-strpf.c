@@ -41,6 +41,9 @@
 #if defined HAVE_CONFIG_H
 # include "config.h"
 #endif	/* HAVE_CONFIG_H */
+#if defined HAVE_IMMINTRIN_H
+# include <immintrin.h>
+#endif	/* HAVE_IMMINTRIN_H */
 #include "strops.h"
 #include "token.h"
 #include "dt-core.h"
@@ -61,6 +64,10 @@
 # undef WITH_LEAP_SECONDS
 #endif	/* SKIP_LEAP_ARITH */
 
+#if defined HAVE___M128I && defined __SSE2__
+# define ISO_SSE2
+#endif	/* __m128i && SSE2 */
+
 static int32_t
 try_zone(const char *str, const char **ep)
 {
@@ -146,6 +153,192 @@ __fixup_zdiff(struct dt_dt_s dt, int32_t zdiff)
 	return dt;
 }
 
+/* ISO 8601 fast paths, YYYY-MM-DD?HH:MM:SS */
+#define ISO_DLEN	(10U)
+#define ISO_DTLEN	(19U)
+/* digit and literal positions, the d/t separator at 10 is in neither */
+#define ISO_DMSK	(0x6db6fU)
+#define ISO_LMSK	(0x12090U)
+
+static inline unsigned int
+__iso_2d(const char *sp)
+{
+	return ((unsigned char)sp[0U] ^ '0') * 10U +
+		((unsigned char)sp[1U] ^ '0');
+}
+
+static size_t
+__iso_shape(const char *sp)
+{
+/* return ISO_DTLEN if SP starts with YYYY-MM-DD?HH:MM:SS, ISO_DLEN if
+ * it starts with YYYY-MM-DD only, and 0 otherwise */
+	size_t i;
+
+#if defined ISO_SSE2
+	/* read 32 bytes in one go unless that crosses a page boundary,
+	 * the string might end before and the rest be unmapped */
+	if (LIKELY(((uintptr_t)sp & 0xfffU) <= 0x1000U - 32U)) {
+		const __m128i z = _mm_set1_epi8('0');
+		const __m128i n = _mm_set1_epi8(9);
+		const __m128i tl = _mm_setr_epi8(
+			0, 0, 0, 0, '-', 0, 0, '-', 0, 0, 0, 0, 0, ':', 0, 0);
+		const __m128i th = _mm_setr_epi8(
+			':', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+		__m128i l = _mm_loadu_si128((const __m128i*)sp);
+		__m128i h = _mm_loadu_si128((const __m128i*)(sp + 16U));
+		__m128i dl = _mm_sub_epi8(l, z);
+		__m128i dh = _mm_sub_epi8(h, z);
+		uint32_t dm, lm;
+
+		/* unsigned x - '0' <= 9 iff x is a digit */
+		dl = _mm_cmpeq_epi8(_mm_min_epu8(dl, n), dl);
+		dh = _mm_cmpeq_epi8(_mm_min_epu8(dh, n), dh);
+		dm = (uint32_t)_mm_movemask_epi8(dl) |
+			(uint32_t)_mm_movemask_epi8(dh) << 16U;
+		lm = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(l, tl)) |
+			(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(h, th)) << 16U;
+		if (LIKELY((dm & ISO_DMSK) == ISO_DMSK &&
+			   (lm & ISO_LMSK) == ISO_LMSK && sp[ISO_DLEN])) {
+			return ISO_DTLEN;
+		} else if ((dm & ISO_DMSK & 0x3ffU) == (ISO_DMSK & 0x3ffU) &&
+			   (lm & ISO_LMSK & 0x3ffU) == (ISO_LMSK & 0x3ffU)) {
+			return ISO_DLEN;
+		}
+		return 0U;
+	}
+#endif	/* ISO_SSE2 */
+	for (i = 0U; i < ISO_DTLEN; i++) {
+		if (ISO_DMSK >> i & 1U) {
+			if ((unsigned char)(sp[i] ^ '0') >= 10U) {
+				break;
+			}
+		} else if (ISO_LMSK >> i & 1U) {
+			if (sp[i] != (i < ISO_DLEN ? '-' : ':')) {
+				break;
+			}
+		} else if (!sp[i]) {
+			/* the string ends after the date */
+			break;
+		}
+	}
+	return i >= ISO_DTLEN ? ISO_DTLEN : i >= ISO_DLEN ? ISO_DLEN : 0U;
+}
+
+static const char*
+__strpdt_iso(struct dt_dt_s *restrict tgt, const char *sp, size_t len)
+{
+/* read the first LEN bytes of a shape vetted by __iso_shape() into TGT,
+ * return a pointer past them or NULL if a field is out of range */
+	struct dt_dt_s res = {DT_UNK};
+	unsigned int y = __iso_2d(sp) * 100U + __iso_2d(sp + 2U);
+	unsigned int m = __iso_2d(sp + 5U);
+	unsigned int d = __iso_2d(sp + 8U);
+
+	if (UNLIKELY(y < DT_MIN_YEAR || y > DT_MAX_YEAR ||
+		     m - 1U >= GREG_MONTHS_P_YEAR || d - 1U >= 31U)) {
+		return NULL;
+	}
+#if !defined WITH_FAST_ARITH
+	/* check for illegal dates, like 31st of April */
+	if (UNLIKELY(d > 28U)) {
+		unsigned int md = __get_mdays(y, m);
+
+		if (d > md) {
+			d = md;
+			res.d.fix = 1U;
+		}
+	}
+#endif	/* !WITH_FAST_ARITH */
+	res.d.ymd.y = y;
+	res.d.ymd.m = m;
+	res.d.ymd.d = d;
+	if (len < ISO_DTLEN) {
+		dt_make_d_only(&res, DT_YMD);
+	} else {
+		unsigned int H = __iso_2d(sp + 11U);
+		unsigned int M = __iso_2d(sp + 14U);
+		unsigned int S = __iso_2d(sp + 17U);
+
+		if (UNLIKELY(H >= 24U || M >= 60U || S > 60U)) {
+			return NULL;
+		}
+		res.t.hms.h = H;
+		res.t.hms.m = M;
+		res.t.hms.s = S;
+		dt_make_sandwich(&res, DT_YMD, DT_HMS);
+	}
+	*tgt = res;
+	return sp + len;
+}
+
+static const char*
+__strpdt_iso_ns(struct dt_dt_s *restrict tgt, const char *sp)
+{
+/* read the digits after the . of a fractional second,
+ * like strtoi_lim() at most 9 of them */
+	static const uint32_t scal[] = {
+		0U, 100000000U, 10000000U, 1000000U, 100000U,
+		10000U, 1000U, 100U, 10U, 1U,
+	};
+	uint32_t ns = 0U;
+	size_t i;
+
+	for (i = 0U; i < 9U && (unsigned char)(sp[i] ^ '0') < 10U; i++) {
+		ns *= 10U, ns += (unsigned char)(sp[i] ^ '0');
+	}
+	if (UNLIKELY(!i)) {
+		return NULL;
+	}
+	tgt->t.hms.ns = ns * scal[i];
+	return sp + i;
+}
+
+static size_t
+__strfdt_iso(char *restrict buf, struct dt_dt_s that, size_t len, char sep)
+{
+/* print the YMD THAT as LEN bytes of YYYY-MM-DD?HH:MM:SS.NNNNNNNNN
+ * with SEP as d/t separator, the time is naught unless THAT has one */
+	unsigned int y = that.d.ymd.y;
+	unsigned int H = 0U, M = 0U, S = 0U;
+	uint32_t ns = 0U;
+
+	buf[0U] = (char)('0' + y / 1000U);
+	buf[1U] = (char)('0' + y / 100U % 10U);
+	buf[2U] = (char)('0' + y / 10U % 10U);
+	buf[3U] = (char)('0' + y % 10U);
+	buf[4U] = '-';
+	buf[5U] = (char)('0' + that.d.ymd.m / 10U);
+	buf[6U] = (char)('0' + that.d.ymd.m % 10U);
+	buf[7U] = '-';
+	buf[8U] = (char)('0' + that.d.ymd.d / 10U);
+	buf[9U] = (char)('0' + that.d.ymd.d % 10U);
+	if (len < ISO_DTLEN) {
+		return len;
+	}
+	if (dt_sandwich_p(that)) {
+		H = that.t.hms.h;
+		M = that.t.hms.m;
+		S = that.t.hms.s;
+		ns = that.t.hms.ns;
+	}
+	buf[10U] = sep;
+	buf[11U] = (char)('0' + H / 10U);
+	buf[12U] = (char)('0' + H % 10U);
+	buf[13U] = ':';
+	buf[14U] = (char)('0' + M / 10U);
+	buf[15U] = (char)('0' + M % 10U);
+	buf[16U] = ':';
+	buf[17U] = (char)('0' + S / 10U);
+	buf[18U] = (char)('0' + S % 10U);
+	if (len > ISO_DTLEN) {
+		buf[ISO_DTLEN] = '.';
+		for (size_t i = len; --i > ISO_DTLEN; ns /= 10U) {
+			buf[i] = (char)('0' + ns % 10U);
+		}
+	}
+	return len;
+}
+
 DEFUN struct dt_dt_s
 __strpdt_std(const char *str, char **ep)
 {
@@ -171,6 +364,46 @@ __strpdt_std(const char *str, char **ep)
 		}
 		goto out;
 	}
+	/* canonical ISO 8601 first */
+	switch (__iso_shape(sp)) {
+		const char *tp;
+	case ISO_DTLEN:
+		if (sp[ISO_DLEN] == 'T' || sp[ISO_DLEN] == ' ' ||
+		    sp[ISO_DLEN] == '\t') {
+			if ((tp = __strpdt_iso(&res, sp, ISO_DTLEN)) == NULL) {
+				break;
+			}
+			str = sp + ISO_DLEN;
+			d.st.h = res.t.hms.h;
+			d.st.m = res.t.hms.m;
+			d.st.s = res.t.hms.s;
+			sp = tp;
+			goto frac;
+		}
+		/*@fallthrough@*/
+	case ISO_DLEN:
+		switch (sp[ISO_DLEN]) {
+		case '0' ... '9':
+		case '-':
+		case 'B':
+		case 'b':
+			/* ymcws, bizdas, long days */
+		case 'T':
+		case ' ':
+		case '\t':
+			/* could still be a time of some sort */
+			break;
+		default:
+			if ((tp = __strpdt_iso(&res, sp, ISO_DLEN)) != NULL) {
+				sp = tp;
+				goto out;
+			}
+			break;
+		}
+		break;
+	default:
+		break;
+	}
 	with (char *tmp) {
 		/* let date-core do the hard yakka */
 		if ((res.d = __strpd_std(str, &tmp)).typ == DT_DUNK) {
@@ -206,11 +439,12 @@ try_time:
 		goto eval_time;
 	} else if ((sp++, d.st.s = strtoi_lim(sp, &sp, 0, 60)) < 0) {
 		d.st.s = 0;
-	} else if (*sp != '.') {
 		goto eval_time;
-	} else if ((sp++, d.st.ns = strtoi_lim(sp, &sp, 0, 999999999)) < 0) {
+	}
+frac:
+	if (*sp == '.' &&
+	    (sp++, d.st.ns = strtoi_lim(sp, &sp, 0, 999999999)) < 0) {
 		d.st.ns = 0;
-		goto eval_time;
 	}
 eval_time:
 	if (UNLIKELY(d.st.h == 24)) {
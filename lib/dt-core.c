@@ -516,9 +516,9 @@ leaps_before(struct dt_dt_s d)
 		break;
 	case DT_SEXY:
 	case DT_SEXYTAI:
-		res = leaps_before_si32(leaps_s, nleaps, (int32_t)d.sexy);
+		res = leaps_sidx_si64(leaps_sidx, nleaps_sidx, d.sexy);
 		on = (res + 1U < nleaps) &&
-			(leaps_s[res + 1] == (int32_t)d.sexy);
+			((dt_sexy_t)leaps_s[res + 1] == d.sexy);
 		break;
 	default:
 		res = 0;
@@ -593,6 +593,192 @@ need_milfup_p(const char *fmt)
 }
 
 
+static const char*
+__strpdt_op(struct strpdt_s d[static 1U], const char *sp,
+	    struct dt_spec_s spec, char lit)
+{
+/* parse SP according to SPEC, or literal LIT if SPEC is unknown,
+ * return a pointer past the parsed bits or NULL on failure */
+	if (spec.spfl == DT_SPFL_UNK) {
+		/* must be literal */
+		if (lit != *sp++) {
+			return NULL;
+		}
+	} else if (LIKELY(!spec.rom)) {
+		const char *sp_sav = sp;
+		if (__strpdt_card(d, sp, spec, (char**)&sp) < 0) {
+			return NULL;
+		}
+		if (spec.ord &&
+		    __ordinalp(sp_sav, sp - sp_sav, (char**)&sp) < 0) {
+			;
+		}
+		if (spec.bizda) {
+			switch (*sp++) {
+			case 'B':
+				d->sd.flags.ab = BIZDA_BEFORE;
+			case 'b':
+				d->sd.flags.bizda = 1;
+				break;
+			default:
+				/* it's a bizda anyway */
+				d->sd.flags.bizda = 1;
+				sp--;
+				break;
+			}
+		}
+	} else if (UNLIKELY(spec.rom)) {
+		if (__strpd_rom(&d->sd, sp, spec, (char**)&sp) < 0) {
+			return NULL;
+		}
+	}
+	return sp;
+}
+
+static struct dt_dt_s
+__strpdt_fin(struct strpdt_s d)
+{
+/* turn the parsed bits into a date/time */
+	struct dt_dt_s res = {DT_UNK};
+
+	/* check if it's a sexy type */
+	if (d.i) {
+		res.typ = DT_SEXY;
+		res.sexy = d.i;
+	} else {
+		/* assign d and t types using date and time core routines */
+		d = massage_strpdt(d);
+		res.d = __guess_dtyp(d.sd);
+		res.t = __guess_ttyp(d.st);
+
+		if (res.d.typ > DT_DUNK && res.t.typ > DT_TUNK) {
+			res.sandwich = 1;
+		} else if (res.d.typ > DT_DUNK) {
+			res.t.typ = DT_TUNK;
+			res.sandwich = 0;
+		} else if (res.t.typ > DT_TUNK) {
+			res.d.typ = DT_DUNK;
+			res.sandwich = 1;
+		}
+	}
+	if (d.zdiff && dt_sandwich_p(res)) {
+		res = __fixup_zdiff(res, d.zdiff);
+	} else if (d.zngvn && dt_sandwich_p(res)) {
+		res.znfxd = 1;
+	}
+	return res;
+}
+
+static int
+__strfdt_prep(struct strpdt_s d[static 1U], struct dt_dt_s that[static 1U],
+	      bool milfup_p)
+{
+/* prepare D for printing THAT, return -1 if there's nothing to print */
+	/* fix up before printing */
+	if (LIKELY(dt_sandwich_p(*that) || dt_sandwich_only_d_p(*that))) {
+		that->d = dt_dfixup(that->d);
+	}
+	/* make sure we always snarf the zdiff info */
+	d->zdiff = zdiff_sec(*that);
+
+	if (milfup_p) {
+		/* military midnight fixup */
+		*that = dt_milfup(*that);
+	}
+
+	switch (that->typ) {
+	case DT_YMD:
+	ymd_prep:
+		d->sd.y = that->d.ymd.y;
+		d->sd.m = that->d.ymd.m;
+		d->sd.d = that->d.ymd.d;
+		break;
+	case DT_YMCW:
+		d->sd.y = that->d.ymcw.y;
+		d->sd.m = that->d.ymcw.m;
+		d->sd.c = that->d.ymcw.c;
+		d->sd.w = that->d.ymcw.w;
+		break;
+	case DT_YWD:
+		__prep_strfd_ywd(&d->sd, that->d.ywd);
+		break;
+	case DT_YD:
+		d->sd.y = that->d.yd.y;
+		d->sd.d = that->d.yd.d;
+		d->sd.flags.d_dcnt_p = 1U;
+		break;
+	case DT_JDN:
+	case DT_LDN:
+	case DT_MDN:
+		*that = dt_dtconv((dt_dttyp_t)DT_DAISY, *that);
+		goto daisy_prep;
+	case DT_DAISY:
+	daisy_prep:
+		__prep_strfd_daisy(&d->sd, that->d.daisy);
+		break;
+
+	case DT_BIZDA:
+		__prep_strfd_bizda(
+			&d->sd, that->d.bizda, __get_bizda_param(that->d));
+		break;
+
+	case DT_SEXY:
+		/* instead of leaving this as SEXY turn it into
+		 * DAISY/HMS sandwich */
+		*that = dt_dtconv((dt_dttyp_t)DT_DAISY, *that);
+		/* prep d.sd */
+		goto daisy_prep;
+	case DT_YMDHMS:
+		/* convert this to a YMD/HMS sandwich */
+		*that = dt_dtconv((dt_dttyp_t)DT_YMD, *that);
+		/* prep d.sd */
+		goto ymd_prep;
+
+	default:
+	case DT_DUNK:
+		if (!dt_sandwich_only_t_p(*that)) {
+			return -1;
+		}
+	}
+
+	if (dt_sandwich_p(*that) || dt_sandwich_only_t_p(*that)) {
+		/* cope with the time part */
+		d->st.h = that->t.hms.h;
+		d->st.m = that->t.hms.m;
+		d->st.s = that->t.hms.s;
+		d->st.ns = that->t.hms.ns;
+	}
+	return 0;
+}
+
+static char*
+__strfdt_op(char *bp, char *const eo, struct dt_spec_s spec, char lit,
+	    struct strpdt_s d[static 1U], struct dt_dt_s that)
+{
+/* print THAT (prepped in D) according to SPEC or literal LIT
+ * if SPEC is unknown, return the new end of the buffer */
+	if (spec.spfl == DT_SPFL_UNK) {
+		/* must be literal then */
+		*bp++ = lit;
+	} else if (LIKELY(!spec.rom)) {
+		bp += __strfdt_card(bp, eo - bp, spec, d, that);
+		if (spec.ord) {
+			bp += __ordtostr(bp, eo - bp);
+		} else if (spec.bizda) {
+			/* don't print the b after an ordinal */
+			if (spec.ab == BIZDA_AFTER) {
+				*bp++ = 'b';
+			} else {
+				*bp++ = 'B';
+			}
+		}
+	} else if (UNLIKELY(spec.rom)) {
+		bp += __strfd_rom(bp, eo - bp, spec, &d->sd, that.d);
+	}
+	return bp;
+}
+
+
 /* parser implementations */
 DEFUN struct dt_dt_s
 dt_strpdt(const char *str, const char *fmt, char **ep)
@@ -686,69 +872,15 @@ dt_strpdt(const char *str, const char *fmt, char **ep)
 		const char *fp_sav = fp;
 		struct dt_spec_s spec = __tok_spec(fp_sav, &fp);
 
-		if (spec.spfl == DT_SPFL_UNK) {
-			/* must be literal */
-			if (*fp_sav != *sp++) {
-				goto fucked;
-			}
-		} else if (LIKELY(!spec.rom)) {
-			const char *sp_sav = sp;
-			if (__strpdt_card(&d, sp, spec, (char**)&sp) < 0) {
-				goto fucked;
-			}
-			if (spec.ord &&
-			    __ordinalp(sp_sav, sp - sp_sav, (char**)&sp) < 0) {
-				;
-			}
-			if (spec.bizda) {
-				switch (*sp++) {
-				case 'B':
-					d.sd.flags.ab = BIZDA_BEFORE;
-				case 'b':
-					d.sd.flags.bizda = 1;
-					break;
-				default:
-					/* it's a bizda anyway */
-					d.sd.flags.bizda = 1;
-					sp--;
-					break;
-				}
-			}
-		} else if (UNLIKELY(spec.rom)) {
-			if (__strpd_rom(&d.sd, sp, spec, (char**)&sp) < 0) {
-				goto fucked;
-			}
+		if ((sp = __strpdt_op(&d, sp, spec, *fp_sav)) == NULL) {
+			goto fucked;
 		}
 	}
 	/* check suffix literal */
 	if (*fp && *fp != *sp) {
 		goto fucked;
 	}
-	/* check if it's a sexy type */
-	if (d.i) {
-		res.typ = DT_SEXY;
-		res.sexy = d.i;
-	} else {
-		/* assign d and t types using date and time core routines */
-		d = massage_strpdt(d);
-		res.d = __guess_dtyp(d.sd);
-		res.t = __guess_ttyp(d.st);
-
-		if (res.d.typ > DT_DUNK && res.t.typ > DT_TUNK) {
-			res.sandwich = 1;
-		} else if (res.d.typ > DT_DUNK) {
-			res.t.typ = DT_TUNK;
-			res.sandwich = 0;
-		} else if (res.t.typ > DT_TUNK) {
-			res.d.typ = DT_DUNK;
-			res.sandwich = 1;
-		}
-	}
-	if (d.zdiff && dt_sandwich_p(res)) {
-		res = __fixup_zdiff(res, d.zdiff);
-	} else if (d.zngvn && dt_sandwich_p(res)) {
-		res.znfxd = 1;
-	}
+	res = __strpdt_fin(d);
 
 sober:
 	/* set the end pointer */
@@ -863,117 +995,231 @@ dt_strfdt(char *restrict buf, size_t bsz, const char *fmt, struct dt_dt_s that)
 		__trans_tfmt(&fmt);
 	}
 
-	/* fix up before printing */
-	if (LIKELY(dt_sandwich_p(that) || dt_sandwich_only_d_p(that))) {
-		that.d = dt_dfixup(that.d);
+	/* military midnights only when there's no %H or %T, don't decay */
+	if (__strfdt_prep(&d, &that,
+			  dt_sandwich_p(that) && that.t.hms.h == 24U &&
+			  need_milfup_p(fmt)) < 0) {
+		bp = buf;
+		goto out;
 	}
-	/* make sure we always snarf the zdiff info */
-	d.zdiff = zdiff_sec(that);
 
-	if (dt_sandwich_p(that) && UNLIKELY(that.t.hms.h == 24U)) {
-		/* military midnight fixup
-		 * only when there's %H or %T in the flags, don't decay*/
-		if (need_milfup_p(fmt)) {
-			that = dt_milfup(that);
-		}
+	/* assign and go */
+	bp = buf;
+	fp = fmt;
+	for (char *const eo = buf + bsz; *fp && bp < eo;) {
+		const char *fp_sav = fp;
+		struct dt_spec_s spec = __tok_spec(fp_sav, &fp);
+
+		bp = __strfdt_op(bp, eo, spec, *fp_sav, &d, that);
+	}
+out:
+	if (bp < buf + bsz) {
+		*bp = '\0';
 	}
+	return bp - buf;
+}
 
-	switch (that.typ) {
-	case DT_YMD:
-	ymd_prep:
-		d.sd.y = that.d.ymd.y;
-		d.sd.m = that.d.ymd.m;
-		d.sd.d = that.d.ymd.d;
-		break;
-	case DT_YMCW:
-		d.sd.y = that.d.ymcw.y;
-		d.sd.m = that.d.ymcw.m;
-		d.sd.c = that.d.ymcw.c;
-		d.sd.w = that.d.ymcw.w;
-		break;
-	case DT_YWD:
-		__prep_strfd_ywd(&d.sd, that.d.ywd);
-		break;
-	case DT_YD:
-		d.sd.y = that.d.yd.y;
-		d.sd.d = that.d.yd.d;
-		d.sd.flags.d_dcnt_p = 1U;
-		break;
+/* compiled formats */
+struct dt_fmt_s {
+	/* the format as handed to dt_fmt_compile() */
+	const char *src;
+	/* non-0 if the ops can be used for parsing */
+	unsigned int strp_p:1;
+	/* non-0 if the ops can be used for printing */
+	unsigned int strf_p:1;
+	/* non-0 if military midnights need decaying when printing */
+	unsigned int milfup_p:1;
+	/* length of the ISO 8601 shape the ops amount to, or 0 */
+	unsigned int iso:5;
+	/* the d/t separator of that shape */
+	char isep;
+	size_t nops;
+	struct dt_fop_s {
+		struct dt_spec_s spec;
+		/* the literal if SPEC is unknown */
+		char lit;
+	} ops[];
+};
+
+static size_t
+__fmt_iso(const struct dt_fop_s *op, size_t nops, char *sep)
+{
+/* return the length of YYYY-MM-DD?HH:MM:SS.NNNNNNNNN if the ops are
+ * %F, %F?%T or %F?%T.%N, 0 otherwise */
+#define PLAIN_P(o, x)							\
+	((o).spec.spfl == (x) &&					\
+	 !(o).spec.ord && !(o).spec.rom && !(o).spec.bizda)
+#define LIT_P(o, c)	((o).spec.spfl == DT_SPFL_UNK && (o).lit == (c))
+	if (nops == 0U || !PLAIN_P(op[0U], DT_SPFL_N_DSTD)) {
+		return 0U;
+	} else if (nops == 1U) {
+		return ISO_DLEN;
+	} else if (nops != 3U && nops != 5U) {
+		return 0U;
+	} else if (!LIT_P(op[1U], 'T') && !LIT_P(op[1U], ' ')) {
+		return 0U;
+	} else if (!PLAIN_P(op[2U], DT_SPFL_N_TSTD)) {
+		return 0U;
+	}
+	*sep = op[1U].lit;
+	if (nops == 3U) {
+		return ISO_DTLEN;
+	} else if (!LIT_P(op[3U], '.') || !PLAIN_P(op[4U], DT_SPFL_N_NANO)) {
+		return 0U;
+	}
+	return ISO_DTLEN + 10U;
+#undef PLAIN_P
+#undef LIT_P
+}
+
+DEFUN dt_fmt_t
+dt_fmt_compile(const char *fmt)
+{
+	const char *pfmt = fmt;
+	bool strp_p = true;
+	dt_fmt_t res;
+	size_t nops = 0U;
+
+	if (UNLIKELY(fmt == NULL)) {
+		return NULL;
+	}
+	/* translate high-level format names, for parsing */
+	switch ((dt_dtyp_t)__trans_dtfmt(&pfmt)) {
 	case DT_JDN:
-		that = dt_dtconv((dt_dttyp_t)DT_DAISY, that);
-		goto daisy_prep;
 	case DT_LDN:
-		that = dt_dtconv((dt_dttyp_t)DT_DAISY, that);
-		goto daisy_prep;
 	case DT_MDN:
-		that = dt_dtconv((dt_dttyp_t)DT_DAISY, that);
-		goto daisy_prep;
-	case DT_DAISY:
-	daisy_prep:
-		__prep_strfd_daisy(&d.sd, that.d.daisy);
+		/* those have no specs, use dt_strpdt() for them */
+		pfmt = "";
+		strp_p = false;
 		break;
-
-	case DT_BIZDA:
-		__prep_strfd_bizda(
-			&d.sd, that.d.bizda, __get_bizda_param(that.d));
+	default:
 		break;
+	}
+	for (const char *fp = pfmt; *fp; nops++) {
+		(void)__tok_spec(fp, &fp);
+	}
+	res = malloc(sizeof(*res) + nops * sizeof(*res->ops));
+	if (UNLIKELY(res == NULL)) {
+		return NULL;
+	}
+	res->src = fmt;
+	res->strp_p = strp_p;
+	/* names and literal prefixes need the full dt_strfdt() logic */
+	res->strf_p = *fmt == '%';
+	res->milfup_p = res->strf_p && need_milfup_p(fmt);
+	res->nops = nops;
+	nops = 0U;
+	for (const char *fp = pfmt; *fp; nops++) {
+		const char *fp_sav = fp;
 
-	case DT_SEXY:
-		/* instead of leaving this as SEXY turn it into
-		 * DAISY/HMS sandwich */
-		that = dt_dtconv((dt_dttyp_t)DT_DAISY, that);
-		/* prep d.sd */
-		goto daisy_prep;
-	case DT_YMDHMS:
-		/* convert this to a YMD/HMS sandwich */
-		that = dt_dtconv((dt_dttyp_t)DT_YMD, that);
-		/* prep d.sd */
-		goto ymd_prep;
+		res->ops[nops].spec = __tok_spec(fp_sav, &fp);
+		res->ops[nops].lit = *fp_sav;
+	}
+	res->isep = '\0';
+	res->iso = __fmt_iso(res->ops, res->nops, &res->isep);
+	return res;
+}
 
-	default:
-	case DT_DUNK:
-		if (!dt_sandwich_only_t_p(that)) {
-			bp = buf;
-			goto out;
+DEFUN void
+dt_fmt_free(dt_fmt_t fmt)
+{
+	free(fmt);
+	return;
+}
+
+static const char*
+__strpdt_iso_c(struct dt_dt_s *restrict tgt, const char *sp, dt_fmt_t fmt)
+{
+/* try FMT's ISO 8601 shape on SP, NULL means use the generic ops */
+	size_t len = fmt->iso < ISO_DTLEN ? ISO_DLEN : ISO_DTLEN;
+	const char *tp;
+
+	if (__iso_shape(sp) < len) {
+		return NULL;
+	} else if (len > ISO_DLEN && sp[ISO_DLEN] != fmt->isep) {
+		return NULL;
+	} else if ((tp = __strpdt_iso(tgt, sp, len)) == NULL) {
+		return NULL;
+	} else if (fmt->iso > ISO_DTLEN) {
+		if (*tp != '.') {
+			return NULL;
 		}
+		tp = __strpdt_iso_ns(tgt, tp + 1U);
 	}
+	return tp;
+}
 
-	if (dt_sandwich_p(that) || dt_sandwich_only_t_p(that)) {
-		/* cope with the time part */
-		d.st.h = that.t.hms.h;
-		d.st.m = that.t.hms.m;
-		d.st.s = that.t.hms.s;
-		d.st.ns = that.t.hms.ns;
+DEFUN struct dt_dt_s
+dt_strpdt_c(const char *str, dt_fmt_t fmt, char **ep)
+{
+	struct strpdt_s d = {0};
+	const char *sp = str;
+	const struct dt_fop_s *op, *eop;
+	struct dt_dt_s res;
+
+	if (UNLIKELY(fmt == NULL)) {
+		return __strpdt_std(str, ep);
+	} else if (UNLIKELY(!fmt->strp_p)) {
+		return dt_strpdt(str, fmt->src, ep);
+	} else if (fmt->iso && (sp = __strpdt_iso_c(&res, str, fmt))) {
+		if (ep != NULL) {
+			*ep = (char*)sp;
+		}
+		return res;
+	}
+	sp = str;
+	for (op = fmt->ops, eop = op + fmt->nops; op < eop && *sp; op++) {
+		if ((sp = __strpdt_op(&d, sp, op->spec, op->lit)) == NULL) {
+			goto fucked;
+		}
 	}
+	/* the format must be exhausted */
+	if (op < eop) {
+		goto fucked;
+	}
+	res = __strpdt_fin(d);
+	if (ep != NULL) {
+		*ep = (char*)sp;
+	}
+	return res;
+fucked:
+	if (ep != NULL) {
+		*ep = (char*)str;
+	}
+	return (struct dt_dt_s){DT_UNK};
+}
 
-	/* assign and go */
-	bp = buf;
-	fp = fmt;
-	for (char *const eo = buf + bsz; *fp && bp < eo;) {
-		const char *fp_sav = fp;
-		struct dt_spec_s spec = __tok_spec(fp_sav, &fp);
+DEFUN size_t
+dt_strfdt_c(char *restrict buf, size_t bsz, dt_fmt_t fmt, struct dt_dt_s that)
+{
+	struct strpdt_s d = {0};
+	char *bp = buf;
+	char *const eo = buf + bsz;
 
-		if (spec.spfl == DT_SPFL_UNK) {
-			/* must be literal then */
-			*bp++ = *fp_sav;
-		} else if (LIKELY(!spec.rom)) {
-			bp += __strfdt_card(bp, eo - bp, spec, &d, that);
-			if (spec.ord) {
-				bp += __ordtostr(bp, eo - bp);
-			} else if (spec.bizda) {
-				/* don't print the b after an ordinal */
-				if (spec.ab == BIZDA_AFTER) {
-					*bp++ = 'b';
-				} else {
-					*bp++ = 'B';
-				}
-			}
-		} else if (UNLIKELY(spec.rom)) {
-			bp += __strfd_rom(bp, eo - bp, spec, &d.sd, that.d);
+	if (UNLIKELY(fmt == NULL || !fmt->strf_p)) {
+		return dt_strfdt(buf, bsz, fmt ? fmt->src : NULL, that);
+	} else if (UNLIKELY(buf == NULL || bsz == 0)) {
+		goto out;
+	} else if (fmt->iso && bsz > fmt->iso && that.d.typ == DT_YMD &&
+		   (!dt_sandwich_p(that) || that.t.hms.h < 24U)) {
+		/* canonical ISO 8601, skip the generic machinery */
+		if (UNLIKELY(that.d.ymd.d > 28U)) {
+			that.d = dt_dfixup(that.d);
 		}
+		bp += __strfdt_iso(buf, that, fmt->iso, fmt->isep);
+		goto out;
+	} else if (__strfdt_prep(&d, &that,
+				 dt_sandwich_p(that) && that.t.hms.h == 24U &&
+				 fmt->milfup_p) < 0) {
+		goto out;
+	}
+
+	for (const struct dt_fop_s *op = fmt->ops, *const eop = op + fmt->nops;
+	     op < eop && bp < eo; op++) {
+		bp = __strfdt_op(bp, eo, op->spec, op->lit, &d, that);
 	}
 out:
-	if (bp < buf + bsz) {
+	if (bp < eo) {
 		*bp = '\0';
 	}
 	return bp - buf;
@@ -1401,13 +1647,15 @@ dt_dtconv(dt_dttyp_t tgttyp, struct dt_dt_s d)
 			unsigned int ss = __secs_since_midnight(d.t);
 
 			switch (tgttyp) {
-				int32_t sx;
+				dt_ssexy_t sx;
 #if defined WITH_LEAP_SECONDS
 			case DT_SEXYTAI: {
 				zidx_t zi;
 
-				sx = (dd - DAISY_UNIX_BASE) * SECS_PER_DAY + ss;
-				zi = leaps_before_si32(leaps_s, nleaps, sx);
+				sx = (dt_ssexy_t)(dd - DAISY_UNIX_BASE) * SECS_PER_DAY;
+				sx += ss;
+				/* no leap seconds beyond the 32bit range anyway */
+				zi = leaps_sidx_si64(leaps_sidx, nleaps_sidx, sx);
 				d.sexy = sx + leaps_corr[zi];
 				break;
 			}
@@ -1415,7 +1663,8 @@ dt_dtconv(dt_dttyp_t tgttyp, struct dt_dt_s d)
 			case DT_SEXYTAI:
 #endif	/* WITH_LEAP_SECONDS */
 			case DT_SEXY:
-				sx = (dd - DAISY_UNIX_BASE) * SECS_PER_DAY + ss;
+				sx = (dt_ssexy_t)(dd - DAISY_UNIX_BASE) * SECS_PER_DAY;
+				sx += ss;
 				d.sexy = sx;
 				break;
 			default:
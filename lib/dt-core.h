@@ -239,6 +239,32 @@ dt_strpdt(const char *str, const char *fmt, char **ep);
 extern size_t
 dt_strfdt(char *restrict buf, size_t bsz, const char *fmt, struct dt_dt_s);
 
+/**
+ * Compiled formats, i.e. formats tokenised once for repeated use. */
+typedef struct dt_fmt_s *dt_fmt_t;
+
+/**
+ * Compile FMT for use with dt_strpdt_c() and dt_strfdt_c().
+ * FMT is interpreted as in dt_strpdt() and dt_strfdt() and must stay
+ * around for the lifetime of the result.
+ * Return NULL if FMT is NULL or if the program cannot be allocated,
+ * a NULL program behaves like a NULL format. */
+extern dt_fmt_t dt_fmt_compile(const char *fmt);
+
+/**
+ * Free resources associated with compiled format FMT. */
+extern void dt_fmt_free(dt_fmt_t fmt);
+
+/**
+ * Like dt_strpdt() but use a compiled format. */
+extern struct dt_dt_s
+dt_strpdt_c(const char *str, dt_fmt_t fmt, char **ep);
+
+/**
+ * Like dt_strfdt() but use a compiled format. */
+extern size_t
+dt_strfdt_c(char *restrict buf, size_t bsz, dt_fmt_t fmt, struct dt_dt_s);
+
 /**
  * Parse durations as in 1w5d, etc. */
 extern struct dt_dtdur_s
@@ -50,6 +50,9 @@
 #include <fcntl.h>
 #include <sys/stat.h>
 #include <sys/mman.h>
+#if defined HAVE_PTHREAD_H
+# include <pthread.h>
+#endif	/* HAVE_PTHREAD_H */
 #include "dt-locale.h"
 #include "date-core.h"
 #include "date-core-strpf.h"
@@ -341,7 +344,7 @@ __strf_reset_long_mon(void)
 static inline void
 __strf_reset_abbr_mon(void)
 {
-	if (dut_abbr_mon != __abbr_mon) {
+	if (duf_abbr_mon != __abbr_mon) {
 		free(deconst(duf_abbr_mon));
 	}
 	duf_abbr_mon = __abbr_mon;
@@ -359,7 +362,7 @@ __strf_set_long_wday(struct lst_s *new)
 static void
 __strf_set_abbr_wday(struct lst_s *new)
 {
-	__strp_reset_abbr_wday();
+	__strf_reset_abbr_wday();
 	duf_abbr_wday = new->s;
 	return;
 }
@@ -367,7 +370,7 @@ __strf_set_abbr_wday(struct lst_s *new)
 static void
 __strf_set_long_mon(struct lst_s *new)
 {
-	__strp_reset_long_mon();
+	__strf_reset_long_mon();
 	duf_long_mon = new->s;
 	return;
 }
@@ -375,7 +378,7 @@ __strf_set_long_mon(struct lst_s *new)
 static void
 __strf_set_abbr_mon(struct lst_s *new)
 {
-	__strp_reset_abbr_mon();
+	__strf_reset_abbr_mon();
 	duf_abbr_mon = new->s;
 	return;
 }
@@ -576,30 +579,104 @@ clo:
 }
 
 
+/* locales named through setilocale()/setflocale(), read on first use */
+DEFVAR const char *dut_ilocale_pend;
+DEFVAR const char *dut_flocale_pend;
+
+#if defined HAVE_PTHREAD_H
+/* threads may need names at the same time, only one of them reads */
+static const pthread_once_t once0 = PTHREAD_ONCE_INIT;
+static pthread_once_t ionce = PTHREAD_ONCE_INIT;
+static pthread_once_t fonce = PTHREAD_ONCE_INIT;
+#else  /* !HAVE_PTHREAD_H */
+static int ionce;
+static int fonce;
+#endif	/* HAVE_PTHREAD_H */
+
+static void
+load_il(void)
+{
+	const char *ln = dut_ilocale_pend;
+
+	(void)__setlocale(ln, strlen(ln), set_il);
+	return;
+}
+
+static void
+load_fl(void)
+{
+	const char *ln = dut_flocale_pend;
+
+	(void)__setlocale(ln, strlen(ln), set_fl);
+	return;
+}
+
+DEFUN void
+dut_load_ilocale(void)
+{
+#if defined HAVE_PTHREAD_H
+	pthread_once(&ionce, load_il);
+#else  /* !HAVE_PTHREAD_H */
+	if (!ionce) {
+		ionce = 1;
+		load_il();
+	}
+#endif	/* HAVE_PTHREAD_H */
+	return;
+}
+
+DEFUN void
+dut_load_flocale(void)
+{
+#if defined HAVE_PTHREAD_H
+	pthread_once(&fonce, load_fl);
+#else  /* !HAVE_PTHREAD_H */
+	if (!fonce) {
+		fonce = 1;
+		load_fl();
+	}
+#endif	/* HAVE_PTHREAD_H */
+	return;
+}
+
 int
 setilocale(const char *ln)
 {
-	size_t lz;
-
-	if (UNLIKELY(ln == NULL || !(lz = strlen(ln)))) {
-		reset_il();
+	/* whatever we had before goes */
+	dut_ilocale_pend = NULL;
+#if defined HAVE_PTHREAD_H
+	ionce = once0;
+#else  /* !HAVE_PTHREAD_H */
+	ionce = 0;
+#endif	/* HAVE_PTHREAD_H */
+	reset_il();
+
+	if (UNLIKELY(ln == NULL || !*ln)) {
 		return 0;
 	}
-
-	return __setlocale(ln, lz, set_il);
+	/* the locale file is read when a name is first needed */
+	dut_ilocale_pend = ln;
+	return 0;
 }
 
 int
 setflocale(const char *ln)
 {
-	size_t lz;
-
-	if (UNLIKELY(ln == NULL || !(lz = strlen(ln)))) {
-		reset_fl();
+	/* whatever we had before goes */
+	dut_flocale_pend = NULL;
+#if defined HAVE_PTHREAD_H
+	fonce = once0;
+#else  /* !HAVE_PTHREAD_H */
+	fonce = 0;
+#endif	/* HAVE_PTHREAD_H */
+	reset_fl();
+
+	if (UNLIKELY(ln == NULL || !*ln)) {
 		return 0;
 	}
-
-	return __setlocale(ln, lz, set_fl);
+	/* the locale file is read when a name is first needed */
+	dut_flocale_pend = ln;
+	return 0;
 }
 
 /* locale.c ends here */
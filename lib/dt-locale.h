@@ -89,15 +89,53 @@ extern const char *dut_abab_mon;
 extern const ssize_t dut_nabab_mon;
 
 
+/**
+ * Names of the input and formatting locales, NULL for the built-in one.
+ * Loaded on first use through dut_load_ilocale()/dut_load_flocale(). */
+extern const char *dut_ilocale_pend;
+extern const char *dut_flocale_pend;
+
+/**
+ * Load the pending input or formatting locale.
+ * Safe to call from several threads at once, the file is read once. */
+extern void dut_load_ilocale(void);
+extern void dut_load_flocale(void);
+
+
 /* public API */
 /**
  * Set input locale (only LC_TIME values) to LOCALE.
- * Just as stupid as setlocale(3). */
+ * Just as stupid as setlocale(3).
+ * The locale file is only read when a name is first needed, so
+ * LOCALE must stay valid until then or until the next call.
+ * Not to be called while other threads use names. */
 extern int setilocale(const char *locale);
 
 /**
  * Set formatting locale (only LC_TIME values) to LOCALE.
- * Just as stupid as setlocale(3). */
+ * Same caveats as for setilocale(). */
 extern int setflocale(const char *locale);
 
+/**
+ * Make sure the dut_* names reflect the input locale. */
+static inline void
+dut_need_ilocale(void)
+{
+	if (dut_ilocale_pend != NULL) {
+		dut_load_ilocale();
+	}
+	return;
+}
+
+/**
+ * Make sure the duf_* names reflect the formatting locale. */
+static inline void
+dut_need_flocale(void)
+{
+	if (dut_flocale_pend != NULL) {
+		dut_load_flocale();
+	}
+	return;
+}
+
 #endif	/* INCLUDED_dt_locale_h_ */
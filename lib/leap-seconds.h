@@ -3,6 +3,7 @@
 #define INCLUDED_leap_seconds_h_
 
 #include <stdint.h>
+#include "leaps.h"
 
 /**
  * Number of known leap corrections. */
@@ -28,6 +29,11 @@ extern const uint32_t leaps_d[];
  * sexy representation of transitions. */
 extern const int32_t leaps_s[];
 
+/**
+ * Direct index over leaps_s, see leaps_sidx_si64(). */
+extern const struct leaps_sidx_s leaps_sidx[];
+extern const size_t nleaps_sidx;
+
 /**
  * HMS representation of transitions. */
 extern const uint32_t leaps_hms[];
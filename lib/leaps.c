@@ -56,28 +56,20 @@ typedef ssize_t sidx_t;
 /* this can be called roughly 100m/sec */
 #define DEF_FIND_BEFORE(N, X)					\
 static zidx_t							\
-find_before_##N(						\
-	const X v[], size_t nv, X key, zidx_t i, zidx_t min, zidx_t max) \
+find_before_##N(const X v[], X key, zidx_t min, zidx_t max)	\
 {								\
-/* Given key K find the index of the transition before */	\
-	do {							\
-		X lo, up;					\
+/* Given key K find the index of the transition before,	\
+ * i.e. the last I in [MIN, MAX] with V[I] < KEY, or MIN */	\
+	while (min < max) {					\
+		zidx_t i = (min + max + 1U) / 2U;		\
 								\
-		lo = v[i];					\
-		up = v[i + 1];					\
-								\
-		if (key > lo && key <= up) {			\
-			/* found him */				\
-			break;					\
-		} else if (key > up) {				\
-			min = i + 1;				\
-			i = (i + max) / 2;			\
-		} else if (key <= lo) {				\
-			max = i - 1;				\
-			i = (i + min) / 2;			\
+		if (v[i] < key) {				\
+			min = i;				\
+		} else {					\
+			max = i - 1U;				\
 		}						\
-	} while (max > min && i < nv);				\
-	return i;						\
+	}							\
+	return min;						\
 }								\
 static const int UNUSED(defined_find_before_##name##_p)
 
@@ -91,41 +83,42 @@ DEF_FIND_BEFORE(si64, int64_t);
 DEFUN zidx_t
 leaps_before_ui32(const uint32_t fld[], size_t nfld, uint32_t key)
 {
-	zidx_t min = 0;
-	zidx_t max = nfld - 1;
-	zidx_t this = max / 2;
-
-	return find_before_ui32(fld, nfld, key, this, min, max);
+	return find_before_ui32(fld, key, 0U, nfld - 1U);
 }
 
 DEFUN zidx_t
 leaps_before_si32(const int32_t fld[], size_t nfld, int32_t key)
 {
-	zidx_t min = 0;
-	zidx_t max = nfld - 1;
-	zidx_t this = max / 2;
-
-	return find_before_si32(fld, nfld, key, this, min, max);
+	return find_before_si32(fld, key, 0U, nfld - 1U);
 }
 
 DEFUN zidx_t
 leaps_before_ui64(const uint64_t fld[], size_t nfld, uint64_t key)
 {
-	zidx_t min = 0;
-	zidx_t max = nfld - 1;
-	zidx_t this = max / 2;
-
-	return find_before_ui64(fld, nfld, key, this, min, max);
+	return find_before_ui64(fld, key, 0U, nfld - 1U);
 }
 
 DEFUN zidx_t
 leaps_before_si64(const int64_t fld[], size_t nfld, int64_t key)
 {
-	zidx_t min = 0;
-	zidx_t max = nfld - 1;
-	zidx_t this = max / 2;
+	return find_before_si64(fld, key, 0U, nfld - 1U);
+}
+
+DEFUN zidx_t
+leaps_sidx_si64(const struct leaps_sidx_s idx[], size_t nidx, int64_t key)
+{
+/* no branches in here, the clamps are conditional moves */
+	int64_t k = key < 0 ? 0 : key > INT32_MAX ? INT32_MAX : key;
+	size_t b = (uint64_t)k >> LEAPS_SIDX_SHIFT;
+
+	b = b < nidx ? b : nidx - 1U;
+	return idx[b].i + (k > idx[b].thr);
+}
 
-	return find_before_si64(fld, nfld, key, this, min, max);
+DEFUN zidx_t
+leaps_sidx_si32(const struct leaps_sidx_s idx[], size_t nidx, int32_t key)
+{
+	return leaps_sidx_si64(idx, nidx, key);
 }
 
 #endif	/* INCLUDED_leaps_c_ */
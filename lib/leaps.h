@@ -57,6 +57,18 @@ struct zleap_s {
 	int32_t corr;
 };
 
+/* direct index over an int32_t field of transitions, bucketed by
+ * KEY >> LEAPS_SIDX_SHIFT for 0 <= KEY <= INT32_MAX,
+ * this needs the transitions to be more than 2^LEAPS_SIDX_SHIFT apart */
+#define LEAPS_SIDX_SHIFT	(22U)
+
+struct leaps_sidx_s {
+	/* the transition within this bucket, or INT32_MAX */
+	int32_t thr;
+	/* index of the last transition before the bucket */
+	uint32_t i;
+};
+
 /* col-based funs */
 /**
  * Return last leap transition before KEY in a uint32_t field FLD. */
@@ -74,6 +86,18 @@ extern zidx_t leaps_before_ui64(const uint64_t fld[], size_t nfld, uint64_t key)
  * Return last leap transition before KEY in a int64_t field FLD. */
 extern zidx_t leaps_before_si64(const int64_t fld[], size_t nfld, int64_t key);
 
+/**
+ * Return last leap transition before KEY using the direct index IDX,
+ * like leaps_before_si32() on the field IDX was built from. */
+extern zidx_t
+leaps_sidx_si32(const struct leaps_sidx_s idx[], size_t nidx, int32_t key);
+
+/**
+ * Like leaps_sidx_si32() but for 64bit keys, keys beyond the int32_t
+ * range are clamped. */
+extern zidx_t
+leaps_sidx_si64(const struct leaps_sidx_s idx[], size_t nidx, int64_t key);
+
 #if defined __cplusplus
 }
 #endif	/* __cplusplus */
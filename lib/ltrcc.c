@@ -316,6 +316,66 @@ const uint32_t %s[] = {\n\
 	return 0;
 }
 
+static int
+pr_line_sidx(const char *line, size_t llen, va_list UNUSED(vap))
+{
+	static long int vals[256U];
+	static size_t nvals;
+	unsigned long int val;
+	char *ep;
+
+	if (llen == PROLOGUE) {
+		/* prologue */
+		fprintf(stdout, "\
+const struct leaps_sidx_s %s[] = {\n", line);
+		return 0;
+	} else if (llen == EPILOGUE) {
+		/* epilogue, one bucket per 2^LEAPS_SIDX_SHIFT seconds */
+		const size_t nb = ((size_t)INT32_MAX >> LEAPS_SIDX_SHIFT) + 1U;
+		size_t j = 0U;
+
+		for (size_t b = 0U; b < nb; b++) {
+			const long int beg = (long int)b << LEAPS_SIDX_SHIFT;
+			const long int end = beg + (1L << LEAPS_SIDX_SHIFT);
+			size_t i;
+
+			/* vals[] is sorted, skip those before this bucket */
+			for (; j < nvals && vals[j] < beg; j++);
+			if ((i = j) < nvals && vals[i] < end) {
+				if (i + 1U < nvals && vals[i + 1U] < end) {
+					fputs("\
+#error \"leap transitions too close for leaps_sidx\"\n", stdout);
+				}
+				fprintf(stdout, "\t{0x%lxU/* %li */, %zu},\n",
+					vals[i], vals[i], i);
+			} else {
+				fprintf(stdout, "\t{INT32_MAX, %zu},\n", i);
+			}
+		}
+		fputs("};\n", stdout);
+		nvals = 0U;
+		return 0;
+	} else if (line == NULL) {
+		return -1;
+	} else if (line[0] == '#') {
+		/* comment line */
+		return 0;
+	} else if (line[0] == '\n') {
+		/* empty line */
+		return 0;
+	}
+	/* otherwise process */
+	if ((ep = NULL, val = strtoul(line, &ep, 10), ep == NULL || val == ULONG_MAX)) {
+		return -1;
+	} else if (nvals >= countof(vals)) {
+		return -1;
+	}
+	/* same as leaps_s */
+	val--;
+	vals[nvals++] = ntp_to_unix_epoch(val);
+	return 0;
+}
+
 static int
 pr_file(FILE *fp, const char *var, int(*cb)(const char*, size_t, va_list), ...)
 {
@@ -391,6 +451,10 @@ parse_file(const char *file)
 	rewind(fp);
 	pr_file(fp, "leaps_s", pr_line_dt, DT_YMD, col);
 	rewind(fp);
+	if (col) {
+		pr_file(fp, "leaps_sidx", pr_line_sidx);
+		rewind(fp);
+	}
 	pr_file(fp, "leaps_hms", pr_line_t, DT_HMS, col);
 
 	fputs("\
@@ -392,9 +392,9 @@ arritostr(
 
 #define ALPHABET_SIZE	(256)
 
-/* not reentrant */
-static unsigned char table[ALPHABET_SIZE];
-static unsigned char cycle = 0;
+/* not reentrant, but one table per thread */
+static __thread unsigned char table[ALPHABET_SIZE];
+static __thread unsigned char cycle = 0;
 
 static inline bool
 in_current_set(unsigned char c)
@@ -0,0 +1,145 @@
+/*** tzcc.c -- native zone compiler
+ *
+ * Copyright (C) 2009-2020 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of dateutils.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/stat.h>
+
+#include "tzraw.c"
+#include "nifty.h"
+
+#include "version.c"
+
+
+static int
+mkdir_p(char *fn)
+{
+/* make all directories leading to file FN */
+	for (char *p = fn; (p = strchr(p + 1U, '/')) != NULL; *p = '/') {
+		*p = '\0';
+		if (mkdir(fn, 0777) < 0 && errno != EEXIST) {
+			*p = '/';
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static int
+compile(const char *zone, const char *ofn)
+{
+	zif_t z;
+	int fd = STDOUT_FILENO;
+	int rc = 0;
+
+	if ((z = zif_open(zone)) == NULL) {
+		fprintf(stderr, "Cannot open zone `%s'\n", zone);
+		return -1;
+	} else if (ofn != NULL &&
+		   (fd = open(ofn, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0) {
+		fprintf(stderr, "Cannot open `%s' for writing\n", ofn);
+		rc = -1;
+		goto clo;
+	}
+	if (zif_write(z, fd) < 0) {
+		fprintf(stderr, "Cannot write compiled zone `%s'\n", zone);
+		rc = -1;
+	}
+	if (fd != STDOUT_FILENO) {
+		close(fd);
+	}
+clo:
+	zif_close(z);
+	return rc;
+}
+
+
+#include "tzcc.yucc"
+
+int
+main(int argc, char *argv[])
+{
+	yuck_t argi[1U];
+	int rc = 0;
+
+	if (yuck_parse(argi, argc, argv) < 0) {
+		rc = 1;
+		goto out;
+	} else if (!argi->nargs) {
+		fputs("ZONE argument is mandatory\n", stderr);
+		rc = 1;
+		goto out;
+	} else if (argi->nargs > 1U && argi->directory_arg == NULL) {
+		fputs("Use --directory to compile more than one ZONE\n", stderr);
+		rc = 1;
+		goto out;
+	}
+
+	if (argi->directory_arg == NULL) {
+		rc = compile(argi->args[0U], argi->output_arg) < 0;
+		goto out;
+	}
+	for (size_t i = 0U; i < argi->nargs; i++) {
+		const char *zn = argi->args[i];
+		char ofn[PATH_MAX];
+
+		if ((size_t)snprintf(ofn, sizeof(ofn), "%s/%s",
+				     argi->directory_arg, zn) >= sizeof(ofn)) {
+			fprintf(stderr, "File name too long for `%s'\n", zn);
+			rc = 1;
+			continue;
+		} else if (mkdir_p(ofn) < 0) {
+			fprintf(stderr, "Cannot create directory for `%s'\n", ofn);
+			rc = 1;
+			continue;
+		}
+		rc |= compile(zn, ofn) < 0;
+	}
+
+out:
+	yuck_free(argi);
+	return rc;
+}
+
+/* tzcc.c ends here */
@@ -249,6 +249,71 @@ tzm_close(tzmap_t m)
 	return;
 }
 
+static inline uint32_t
+tzm_hash(const char *s)
+{
+/* 32bit FNV-1a */
+	uint32_t h = 2166136261U;
+
+	for (; *s; s++) {
+		h ^= (unsigned char)*s;
+		h *= 16777619U;
+	}
+	return h;
+}
+
+static const znoff_t*
+tzm_hidx(tzmap_t m, size_t *nslot)
+{
+/* return the hash index of M (and its size in NSLOT) or NULL */
+	const znoff_t *ep = (const void*)tzm_mnames(m);
+	size_t nsl;
+
+	if (tzm_zname_size(m) < 2U * sizeof(*ep)) {
+		return NULL;
+	} else if (memcmp(ep - 1U, TZM_HMAGIC, sizeof(*ep))) {
+		/* TZm1 file without index */
+		return NULL;
+	} else if ((nsl = be32toh(ep[-2])) == 0U || nsl & (nsl - 1U)) {
+		return NULL;
+	} else if ((nsl + 2U) * sizeof(*ep) > tzm_zname_size(m)) {
+		return NULL;
+	}
+	*nslot = nsl;
+	return ep - 2U - nsl;
+}
+
+static const char*
+tzm_hfind(tzmap_t m, const znoff_t *hx, size_t nslot, const char *mname)
+{
+	const znoff_t *mns = (const void*)tzm_mnames(m);
+	const size_t nmn = tzm_mname_size(m) / sizeof(*mns);
+
+	for (size_t i = tzm_hash(mname), j = 0U; j < nslot; i++, j++) {
+		znoff_t x = be32toh(hx[i &= nslot - 1U]);
+		const char *mn;
+		size_t mz;
+
+		if (!x--) {
+			/* empty slot, not in here */
+			break;
+		} else if (UNLIKELY(x >= nmn)) {
+			/* corrupt */
+			break;
+		} else if (strcmp(mn = (const void*)(mns + x), mname)) {
+			continue;
+		}
+		/* found it, the offset word follows the name */
+		mz = strlen(mn);
+		x += (mz - 1U) / sizeof(*mns) + 1U;
+		if (UNLIKELY(x >= nmn)) {
+			break;
+		}
+		return tzm_znames(m) + (be32toh(mns[x]) >> 8U);
+	}
+	return NULL;
+}
+
 DEFUN const char*
 tzm_find(tzmap_t m, const char *mname)
 {
@@ -257,7 +322,15 @@ tzm_find(tzmap_t m, const char *mname)
 	const znoff_t *ep = sp + tzm_mname_size(m) / sizeof(*sp) - 1U;
 	const char *zns = tzm_znames(m);
 
-	/* do a bisection now */
+	with (const znoff_t *hx) {
+		size_t nslot;
+
+		if ((hx = tzm_hidx(m, &nslot)) != NULL) {
+			/* O(1) it is */
+			return tzm_hfind(m, hx, nslot, mname);
+		}
+	}
+	/* old style file, do a bisection now */
 	do {
 		const char *mp = mname;
 		const char *tp;
@@ -372,6 +445,37 @@ tzm_add_mn(const char *mn, size_t mz, znoff_t off)
 	return;
 }
 
+static znoff_t*
+tzm_mk_hidx(size_t *nslot)
+{
+/* build the hash index over the mapped names, laid out as on disk */
+	size_t nmn = 0U;
+	size_t nsl = 16U;
+	znoff_t *hx;
+
+	for (ptrdiff_t i = 0; i < mni; nmn++) {
+		i += (strlen((const char*)(mns + i)) - 1U) / sizeof(*mns) + 2U;
+	}
+	/* keep the load factor at or below 1/2 */
+	for (; nsl < 2U * nmn; nsl *= 2U);
+
+	if (UNLIKELY((hx = calloc(nsl + 2U, sizeof(*hx))) == NULL)) {
+		return NULL;
+	}
+	for (ptrdiff_t i = 0; i < mni;) {
+		const char *mn = (const char*)(mns + i);
+		size_t h = tzm_hash(mn);
+
+		for (; hx[h &= nsl - 1U]; h++);
+		hx[h] = htobe32((znoff_t)i + 1U);
+		i += (strlen(mn) - 1U) / sizeof(*mns) + 2U;
+	}
+	hx[nsl] = htobe32((znoff_t)nsl);
+	memcpy(hx + nsl + 1U, TZM_HMAGIC, sizeof(*hx));
+	*nslot = nsl;
+	return hx;
+}
+
 
 static unsigned int exst_only_p;
 static const char *check_fn;
@@ -662,22 +766,34 @@ cmd_cc(const struct yuck_cmd_cc_s argi[static 1U])
 	/* generate a disk version now */
 	with (znoff_t off = zni) {
 		static struct tzmap_s r = {TZM_MAGIC};
+		znoff_t *hx;
+		size_t nsl;
 		ssize_t sz;
 
 		off = (off + sizeof(off) - 1U) / sizeof(off) * sizeof(off);
-		r.off = htobe32(off);
+		if (UNLIKELY((hx = tzm_mk_hidx(&nsl)) == NULL)) {
+			serror("cannot build hash index");
+			goto trunc;
+		}
+		/* the index goes between zonenames and mapped names */
+		r.off = htobe32(off + (nsl + 2U) * sizeof(*hx));
 		if (sz = sizeof(r), write(ofd, &r, sz) < sz) {
 			goto trunc;
 		} else if (sz = off, write(ofd, zns, sz) < sz) {
 			goto trunc;
+		} else if (sz = (nsl + 2U) * sizeof(*hx),
+			   write(ofd, hx, sz) < sz) {
+			goto trunc;
 		} else if (sz = mni * sizeof(*mns), write(ofd, mns, sz) < sz) {
 			goto trunc;
 		}
+		free(hx);
 		close(ofd);
 		break;
 
 	trunc:
 		/* some write failed, leave a 0 byte file around */
+		free(hx);
 		close(ofd);
 		unlink(outf);
 		rc = 1;
@@ -50,6 +50,14 @@ typedef uint32_t znoff_t;
 
 #define NUL_ZNOFF	((uint32_t)-1)
 
+/* optional hash index, the last thing before the mapped names:
+ * NSLOT big-endian slots, NSLOT itself (big-endian), TZM_HMAGIC
+ * a slot holds 1 + the znoff_t offset of a mapped name record relative
+ * to the mapped names, or 0 if empty, the hash is 32bit FNV-1a
+ * readers unaware of the index see it as padding after the zonenames,
+ * the magic's trailing NUL keeps their bisection from running off */
+#define TZM_HMAGIC	"TZh"
+
 /** disk representation of tzm files */
 struct tzmap_s {
 	/* magic cookie, should be TZM_MAGIC */
@@ -83,7 +83,7 @@
 #endif	/* MAP_ANON->MAP_ANONYMOUS */
 
 typedef struct zih_s *zih_t;
-typedef int32_t *ztr_t;
+typedef int64_t *ztr_t;
 typedef uint8_t *zty_t;
 typedef struct ztrdtl_s *ztrdtl_t;
 typedef char *znam_t;
@@ -119,7 +119,7 @@ struct ztrdtl_s {
 
 /* convenience struct where we copy all the good things into one */
 struct zspec_s {
-	int32_t since;
+	int64_t since;
 	unsigned int offs:31;
 	unsigned int dstp:1;
 	znam_t name;
@@ -133,12 +133,37 @@ struct zleap_tr_s {
 	int32_t corr;
 };
 
+/* POSIX TZ rules (the footer of v2+ files) */
+struct zrule_s {
+	/* offsets to UTC in standard and daylight saving time */
+	int32_t std;
+	int32_t dst;
+	/* non-0 if there's daylight saving time */
+	unsigned int dstp:1;
+	/* when DST begins and ends, in local time */
+	struct zrdat_s {
+		enum {
+			/* Jn, 1-based, Feb 29 is never counted */
+			ZRD_J1,
+			/* n, 0-based, Feb 29 is counted */
+			ZRD_J0,
+			/* Mm.w.d, d-th day of week w in month m */
+			ZRD_MWD,
+		} typ:2;
+		unsigned int m:4;
+		unsigned int w:3;
+		unsigned int d:9;
+		/* time of day of the transition */
+		int32_t secs;
+	} beg, end;
+};
+
 /* leap second support missing */
 struct zif_s {
 	size_t mpsz;
 	zih_t hdr;
 
-	/* transitions */
+	/* transitions, always 64bit, from the v2+ data block if present */
 	ztr_t trs;
 	/* types */
 	zty_t tys;
@@ -153,9 +178,48 @@ struct zif_s {
 	/* for special zones */
 	coord_zone_t cz;
 
-	/* zone caching, between PREV and NEXT the offset is OFFS */
-	struct zrng_s cache;
-};
+	/* non-0 if RULE governs instants after the last transition */
+	unsigned int rulep:1;
+	/* non-0 if HDR points into a mapped native zone file */
+	unsigned int natp:1;
+	struct zrule_s rule;
+
+	/* serial number, keys the per-thread lookup cursors */
+	uint64_t zid;
+
+	/* bucket index into TRS, or NULL, see __init_zidx() */
+	uint16_t *idx;
+	int64_t ibase;
+	unsigned int ishft;
+	/* so that HDR, right behind us, starts on a cache line */
+} __attribute__((aligned(64)));
+
+/* the transition index has this many buckets (plus a sentinel) and
+ * is only built for zones with more than ZIDX_MINTR transitions */
+#define ZIDX_NBKT	(4096U)
+#define ZIDX_MINTR	(8U)
+#define ZIDX_ALGN	(64U)
+
+/* native zone files, this header followed by the in-memory image
+ * (what follows a zif_s) of the zone, all in host byte-order */
+#define TZN_MAGIC	"TZn1"
+#define TZN_BOM		(0x01020304U)
+
+struct znat_s {
+	char magic[4U];
+	/* TZN_BOM in the writer's byte-order */
+	uint32_t bom;
+	/* size of the image */
+	uint64_t isz;
+	/* layout parameters, must match the reader's */
+	uint16_t zrsz;
+	uint16_t nbkt;
+	uint32_t rulep;
+	int64_t ibase;
+	uint32_t ishft;
+	struct zrule_s rule;
+	/* the image must start on a cache line, too */
+} __attribute__((aligned(64)));
 
 
 #if defined TZDIR
@@ -176,7 +240,16 @@ static const char coord_fn[] = "/usr/share/zoneinfo/UTC";
 #define PROT_MEMMAP	PROT_READ | PROT_WRITE
 #define MAP_MEMMAP	MAP_PRIVATE | MAP_ANON
 
-#define AS_MUT_ZIF(x)	((struct zif_s*)deconst(x))
+/* zones are immutable after construction, lookups cache the last range
+ * in a cursor, owned by the caller or by the calling thread */
+#define NZCUR	(4U)
+static __thread struct {
+	uint64_t zid;
+	struct zrng64_s cur;
+} zcur[NZCUR];
+static __thread unsigned int zcur_evict;
+/* last handed out zone serial number */
+static uint64_t zid_last;
 
 /* special zone names */
 static const char coord_zones[][4] = {
@@ -227,14 +300,14 @@ zif_nleaps(const struct zif_s z[static 1U])
 
 /**
  * Return the transition time stamp of the N-th transition in Z. */
-static inline int32_t
+static inline int64_t
 zif_trans(const struct zif_s z[static 1U], int n)
 {
 	size_t ntr = zif_ntrans(z);
 
 	if (UNLIKELY(!ntr || n < 0)) {
 		/* return earliest possible stamp */
-		return INT_MIN;
+		return INT64_MIN;
 	} else if (UNLIKELY(n >= (ssize_t)ntr)) {
 		/* return last known stamp */
 		return z->trs[ntr - 1U];
@@ -343,28 +416,93 @@ __open_zif(const char *file)
 	return open(file, O_RDONLY, 0644);
 }
 
+static inline bool
+__zidx_p(size_t ntr)
+{
+/* whether to index NTR transitions */
+	return ntr > ZIDX_MINTR && ntr <= UINT16_MAX;
+}
+
 static void
 __init_zif(struct zif_s z[static 1U])
 {
-	size_t ntr;
-	size_t nty;
-
-	if (z->fd > STDIN_FILENO) {
-		/* probably in BE then, eh? */
-		ntr = be32toh(zif_ntrans(z));
-		nty = be32toh(zif_ntypes(z));
-	} else {
-		ntr = zif_ntrans(z);
-		nty = zif_ntypes(z);
-	}
+/* set up the pointers into Z's data, which must be in host byte-order */
+	size_t ntr = zif_ntrans(z);
+	size_t nty = zif_ntypes(z);
+	/* the transitions are 64bit, keep them aligned */
+	uintptr_t trs = (uintptr_t)(z->hdr + 1);
 
-	z->trs = (ztr_t)(z->hdr + 1);
+	trs += -trs % sizeof(*z->trs);
+	z->trs = (ztr_t)trs;
 	z->tys = (zty_t)(z->trs + ntr);
 	z->tda = (ztrdtl_t)(z->tys + ntr);
 	z->zn = (char*)(z->tda + nty);
+	z->idx = NULL;
+	if (__zidx_p(ntr)) {
+		/* the index goes last, on its own cache lines */
+		uintptr_t idx = (uintptr_t)(z->zn + zif_nchars(z));
+
+		idx += -idx % ZIDX_ALGN;
+		z->idx = (uint16_t*)idx;
+	}
+	return;
+}
+
+static void
+__init_zidx(struct zif_s z[static 1U])
+{
+/* bucket I covers [IBASE + (I << ISHFT), IBASE + (I + 1 << ISHFT)) and
+ * holds the number of transitions up to and including its start,
+ * ISHFT is chosen so that all stored transitions are covered */
+	const size_t ntr = zif_ntrans(z);
+	uint64_t span;
+	unsigned int s;
+
+	if (z->idx == NULL) {
+		return;
+	}
+	span = (uint64_t)z->trs[ntr - 1U] - (uint64_t)z->trs[0U];
+	for (s = 0U; (span >> s) >= ZIDX_NBKT; s++);
+	z->ibase = z->trs[0U];
+	z->ishft = s;
+
+	for (size_t i = 0U, j = 0U; i < ZIDX_NBKT; i++) {
+		const uint64_t beg = (uint64_t)i << s;
+
+		for (; j < ntr &&
+			     (uint64_t)z->trs[j] - (uint64_t)z->ibase <= beg;
+		     j++);
+		z->idx[i] = (uint16_t)j;
+	}
+	z->idx[ZIDX_NBKT] = (uint16_t)ntr;
 	return;
 }
 
+static size_t
+__zif_dsz(const struct zih_s h[static 1U], size_t tsz)
+{
+/* return the size of the data block after the (hbo) header H, with
+ * time stamps of size TSZ, i.e. 4 in the v1 block and 8 in the v2+ one */
+	return h->tzh_timecnt * (tsz + 1U) +
+		h->tzh_typecnt * sizeof(struct ztrdtl_s) +
+		h->tzh_charcnt +
+		h->tzh_leapcnt * (tsz + 4U) +
+		h->tzh_ttisstdcnt +
+		h->tzh_ttisgmtcnt;
+}
+
+static size_t
+__zif_isz(const struct zih_s h[static 1U])
+{
+/* return the size of our in-memory image for header H */
+	return sizeof(*h) + sizeof(int64_t) +
+		h->tzh_timecnt * (sizeof(int64_t) + 1U) +
+		h->tzh_typecnt * sizeof(struct ztrdtl_s) +
+		h->tzh_charcnt +
+		(__zidx_p(h->tzh_timecnt)
+		 ? ZIDX_ALGN + (ZIDX_NBKT + 1U) * sizeof(uint16_t) : 0U);
+}
+
 static int
 __read_zif(struct zif_s tgt[static 1U], int fd)
 {
@@ -372,7 +510,7 @@ __read_zif(struct zif_s tgt[static 1U], int fd)
 
 	if (fstat(fd, &st) < 0) {
 		return -1;
-	} else if (st.st_size <= 4) {
+	} else if (st.st_size <= (ssize_t)sizeof(*tgt->hdr)) {
 		return -1;
 	}
 	tgt->mpsz = st.st_size;
@@ -380,9 +518,12 @@ __read_zif(struct zif_s tgt[static 1U], int fd)
 	tgt->hdr = mmap(NULL, tgt->mpsz, PROT_READ, MAP_SHARED, fd, 0);
 	if (tgt->hdr == MAP_FAILED) {
 		return -1;
+	} else if (memcmp(tgt->hdr->tzh_magic, TZ_MAGIC, 4U) &&
+		   memcmp(tgt->hdr->tzh_magic, TZN_MAGIC, 4U)) {
+		munmap(tgt->hdr, tgt->mpsz);
+		tgt->hdr = MAP_FAILED;
+		return -1;
 	}
-	/* all clear so far, populate */
-	__init_zif(tgt);
 	return 0;
 }
 
@@ -400,51 +541,240 @@ __conv_hdr(struct zih_s tgt[static 1U], const struct zih_s src[static 1U])
 	return;
 }
 
-static void
-__conv_zif(struct zif_s tgt[static 1U], const struct zif_s src[static 1U])
+static const char*
+__tz_name(const char *sp)
 {
-	size_t ntr;
-	size_t nty;
-	size_t nch;
+/* read over a zone abbreviation in a POSIX TZ string */
+	const char *tp = sp;
 
-	/* convert header to hbo */
-	__conv_hdr(tgt->hdr, src->hdr);
+	if (*sp == '<') {
+		/* quoted form, anything alphanumeric, + or - */
+		for (tp = ++sp; *tp && *tp != '>'; tp++);
+		return *tp == '>' && tp - sp >= 3 ? tp + 1 : NULL;
+	}
+	for (; (*tp >= 'A' && *tp <= 'Z') || (*tp >= 'a' && *tp <= 'z'); tp++);
+	return tp - sp >= 3 ? tp : NULL;
+}
 
-	/* everything in host byte-order already */
-	ntr = zif_ntrans(tgt);
-	nty = zif_ntypes(tgt);
-	nch = zif_nchars(tgt);
-	__init_zif(tgt);
+static const char*
+__tz_secs(const char *sp, int32_t *tgt)
+{
+/* read [+-]hh[:mm[:ss]] off SP, hours can go up to 167 */
+	int32_t res = 0;
+	bool negp = false;
+
+	switch (*sp) {
+	case '-':
+		negp = true;
+		/*@fallthrough@*/
+	case '+':
+		sp++;
+		/*@fallthrough@*/
+	default:
+		break;
+	}
+	for (int i = 0, n = 3600; i < 3; i++, n /= 60) {
+		int32_t x = 0;
+		const char *tp = sp;
 
-	/* transition vector */
-	for (size_t i = 0; i < ntr; i++) {
-		tgt->trs[i] = be32toh(src->trs[i]);
+		if (i && *sp++ != ':') {
+			sp--;
+			break;
+		}
+		for (; (unsigned char)(*sp ^ '0') < 10U && sp - tp < 3; sp++) {
+			x *= 10, x += (unsigned char)(*sp ^ '0');
+		}
+		if (sp == tp || x > (i ? 59 : 167)) {
+			return NULL;
+		}
+		res += x * n;
 	}
+	*tgt = negp ? -res : res;
+	return sp;
+}
 
-	/* type vector, nothing to byte-swap here */
-	memcpy(tgt->tys, src->tys, ntr * sizeof(*tgt->tys));
+static const char*
+__tz_date(const char *sp, struct zrdat_s tgt[static 1U])
+{
+/* read Jn, n or Mm.w.d, optionally followed by /time */
+	unsigned int x[3U] = {0U};
+	size_t n = 1U;
+
+	switch (*sp) {
+	case 'J':
+		tgt->typ = ZRD_J1;
+		sp++;
+		break;
+	case 'M':
+		tgt->typ = ZRD_MWD;
+		n = 3U;
+		sp++;
+		break;
+	default:
+		tgt->typ = ZRD_J0;
+		break;
+	}
+	for (size_t i = 0U; i < n; i++) {
+		const char *tp = sp;
 
-	/* transition details vector */
-	for (size_t i = 0; i < nty; i++) {
-		tgt->tda[i].offs = be32toh(src->tda[i].offs);
-		tgt->tda[i].dstp = src->tda[i].dstp;
-		tgt->tda[i].abbr = src->tda[i].abbr;
+		if (i && *sp++ != '.') {
+			return NULL;
+		}
+		for (tp = sp; (unsigned char)(*sp ^ '0') < 10U; sp++) {
+			x[i] *= 10U, x[i] += (unsigned char)(*sp ^ '0');
+			if (x[i] > 365U) {
+				return NULL;
+			}
+		}
+		if (sp == tp) {
+			return NULL;
+		}
+	}
+	switch (tgt->typ) {
+	case ZRD_J1:
+		if (x[0U] < 1U) {
+			return NULL;
+		}
+		/*@fallthrough@*/
+	case ZRD_J0:
+		tgt->d = x[0U];
+		break;
+	case ZRD_MWD:
+		if (x[0U] < 1U || x[0U] > 12U ||
+		    x[1U] < 1U || x[1U] > 5U || x[2U] > 6U) {
+			return NULL;
+		}
+		tgt->m = x[0U];
+		tgt->w = x[1U];
+		tgt->d = x[2U];
+		break;
 	}
+	/* the default is 02:00:00 */
+	tgt->secs = 7200;
+	if (*sp == '/') {
+		sp = __tz_secs(++sp, &tgt->secs);
+	}
+	return sp;
+}
 
-	/* zone name array */
-	memcpy(tgt->zn, src->zn, nch * sizeof(*tgt->zn));
-	return;
+static int
+__tz_rule(struct zrule_s tgt[static 1U], const char *sp, const char *ep)
+{
+/* parse the POSIX TZ string between SP and EP into TGT */
+	struct zrule_s r = {.dstp = 0U};
+
+	if ((sp = __tz_name(sp)) == NULL || sp >= ep) {
+		return -1;
+	} else if ((sp = __tz_secs(sp, &r.std)) == NULL) {
+		return -1;
+	}
+	/* POSIX offsets are west-positive */
+	r.std = -r.std;
+	r.dst = r.std;
+	if (sp < ep) {
+		if ((sp = __tz_name(sp)) == NULL) {
+			return -1;
+		}
+		r.dstp = 1U;
+		r.dst = r.std + 3600;
+		if (sp < ep && *sp != ',') {
+			if ((sp = __tz_secs(sp, &r.dst)) == NULL) {
+				return -1;
+			}
+			r.dst = -r.dst;
+		}
+		if (sp >= ep) {
+			/* no rule, use the US one like everyone else */
+			sp = ",M3.2.0,M11.1.0";
+			ep = sp + 15U;
+		}
+		if (*sp++ != ',' || (sp = __tz_date(sp, &r.beg)) == NULL) {
+			return -1;
+		} else if (*sp++ != ',' || (sp = __tz_date(sp, &r.end)) == NULL) {
+			return -1;
+		}
+	}
+	if (sp != ep) {
+		return -1;
+	}
+	*tgt = r;
+	return 0;
+}
+
+static inline bool
+__noop_p(const struct ztrdtl_s *tda, uint8_t from, uint8_t to)
+{
+/* check if a transition from type FROM to TO changes nothing */
+	return from == to || !memcmp(tda + from, tda + to, sizeof(*tda));
 }
 
 static struct zif_s*
 __copy_conv(const struct zif_s z[static 1U])
 {
-/* copy Z and do byte-order conversions */
+/* copy the file-backed Z and do byte-order conversions,
+ * if there's a v2+ data block use that for its 64bit transitions */
+	const char *const eof = (const char*)z->hdr + z->mpsz;
+	const char *dp = (const char*)(z->hdr + 1);
+	size_t tsz = sizeof(int32_t);
+	const uint8_t *ftys;
+	const struct ztrdtl_s *ftda;
+	const char *fzn;
+	const char *ftr = NULL;
+	struct zih_s h;
+	size_t ntr;
+	size_t nty;
+	size_t nch;
 	size_t mpsz;
 	struct zif_s *res = NULL;
 
+	__conv_hdr(&h, z->hdr);
+	if (UNLIKELY(__zif_dsz(&h, tsz) > (size_t)(eof - dp))) {
+		/* truncated */
+		return NULL;
+	} else if (h.tzh_version[0U] >= '2') {
+		const struct zih_s *h2 = (const void*)(dp + __zif_dsz(&h, tsz));
+		const char *dp2 = (const char*)(h2 + 1);
+		struct zih_s tmp;
+
+		if (dp2 <= eof && !memcmp(h2->tzh_magic, TZ_MAGIC, 4U) &&
+		    (__conv_hdr(&tmp, h2),
+		     __zif_dsz(&tmp, sizeof(int64_t)) <= (size_t)(eof - dp2))) {
+			/* use the 64bit block */
+			h = tmp;
+			dp = dp2;
+			tsz = sizeof(int64_t);
+			/* the footer is \nTZ-string\n */
+			ftr = dp2 + __zif_dsz(&tmp, tsz);
+		}
+	}
+	ntr = h.tzh_timecnt;
+	nty = h.tzh_typecnt;
+	nch = h.tzh_charcnt;
+	if (UNLIKELY(!nty || nty > 256U)) {
+		/* types are indexed by octets and there must be one */
+		return NULL;
+	}
+	/* the file's vectors */
+	ftys = (const uint8_t*)(dp + ntr * tsz);
+	ftda = (const void*)(ftys + ntr);
+	fzn = (const char*)(ftda + nty);
+
+	/* count the transitions that change anything, zic(8) likes to
+	 * put no-op ones at the 32bit boundaries */
+	h.tzh_timecnt = 0U;
+	for (size_t i = 0; i < ntr; i++) {
+		uint8_t ty = ftys[i];
+
+		if (UNLIKELY(ty >= nty)) {
+			return NULL;
+		} else if (i && __noop_p(ftda, ftys[i - 1U], ty)) {
+			continue;
+		}
+		h.tzh_timecnt++;
+	}
+
 	/* compute a size */
-	mpsz = z->mpsz + sizeof(*z);
+	mpsz = sizeof(*res) + __zif_isz(&h);
 
 	/* we'll mmap ourselves a slightly larger struct so
 	 * res + 1 points to the header, while res + 0 is the zif_t */
@@ -455,15 +785,51 @@ __copy_conv(const struct zif_s z[static 1U])
 	/* great, now to some initial assignments */
 	res->mpsz = mpsz;
 	res->hdr = (void*)(res + 1);
+	*res->hdr = h;
 	/* make sure we denote that this isnt connected to a file */
 	res->fd = -1;
 	/* copy the flags though */
 	res->cz = z->cz;
+	res->zid = __atomic_add_fetch(&zid_last, 1U, __ATOMIC_RELAXED);
+	__init_zif(res);
 
-	/* convert the header and payload now */
-	__conv_zif(res, z);
+	/* transition and type vectors, stamps could be misaligned */
+	for (size_t i = 0, j = 0; i < ntr; i++, dp += tsz) {
+		if (i && __noop_p(ftda, ftys[i - 1U], ftys[i])) {
+			continue;
+		} else if (tsz == sizeof(int64_t)) {
+			uint64_t x;
+
+			memcpy(&x, dp, sizeof(x));
+			res->trs[j] = (int64_t)be64toh(x);
+		} else {
+			uint32_t x;
+
+			memcpy(&x, dp, sizeof(x));
+			res->trs[j] = (int32_t)be32toh(x);
+		}
+		res->tys[j++] = ftys[i];
+	}
+
+	/* transition details vector */
+	for (size_t i = 0; i < nty; i++) {
+		res->tda[i].offs = be32toh(ftda[i].offs);
+		res->tda[i].dstp = ftda[i].dstp;
+		res->tda[i].abbr = ftda[i].abbr;
+	}
 
-	/* that's all :) */
+	/* zone name array */
+	memcpy(res->zn, fzn, nch * sizeof(*res->zn));
+
+	/* index the transitions */
+	__init_zidx(res);
+
+	/* and the rules for the time after the last transition */
+	if (ftr != NULL && ftr < eof && *ftr++ == '\n') {
+		const char *eftr = memchr(ftr, '\n', eof - ftr);
+
+		res->rulep = eftr != NULL && __tz_rule(&res->rule, ftr, eftr) >= 0;
+	}
 	return res;
 }
 
@@ -477,13 +843,103 @@ __copy(const struct zif_s z[static 1U])
 	if (z->fd > STDIN_FILENO) {
 		return __copy_conv(z);
 	}
-	/* otherwise it's a plain copy */
+	/* otherwise it's a plain copy, the image needn't follow Z though */
 	res = mmap(NULL, z->mpsz, PROT_MEMMAP, MAP_MEMMAP, -1, 0);
 	if (UNLIKELY(res == MAP_FAILED)) {
 		return NULL;
 	}
-	memcpy(res, z, z->mpsz);
+	*res = *z;
+	memcpy(res + 1, z->hdr, z->mpsz - sizeof(*z));
+	res->hdr = (void*)(res + 1);
+	res->natp = 0U;
+	res->zid = __atomic_add_fetch(&zid_last, 1U, __ATOMIC_RELAXED);
+	__init_zif(res);
+	return res;
+}
+
+static bool
+__nat_valid_p(const struct zif_s z[static 1U])
+{
+/* check what's used as an index in the mapped image Z */
+	const size_t ntr = zif_ntrans(z);
+	const size_t nty = zif_ntypes(z);
+	const size_t nch = zif_nchars(z);
+
+	/* types index the details */
+	for (size_t i = 0U; i < ntr; i++) {
+		if (UNLIKELY(z->tys[i] >= nty)) {
+			return false;
+		}
+	}
+	/* details index the (\0-terminated) zone names */
+	if (UNLIKELY(!nch || z->zn[nch - 1U])) {
+		return false;
+	}
+	for (size_t i = 0U; i < nty; i++) {
+		if (UNLIKELY(z->tda[i].abbr >= nch)) {
+			return false;
+		}
+	}
+	if (z->idx == NULL) {
+		return true;
+	}
+	/* the buckets must cover the transitions and index into them */
+	if (UNLIKELY(z->ibase != z->trs[0U] || z->ishft >= 64U ||
+		     ((uint64_t)z->trs[ntr - 1U] - (uint64_t)z->ibase) >>
+		     z->ishft >= ZIDX_NBKT)) {
+		return false;
+	}
+	for (size_t i = 0U; i < ZIDX_NBKT; i++) {
+		if (UNLIKELY(z->idx[i] > z->idx[i + 1U])) {
+			return false;
+		}
+	}
+	return z->idx[ZIDX_NBKT] == ntr;
+}
+
+static struct zif_s*
+__open_nat(const struct zif_s z[static 1U])
+{
+/* use the native zone file mapped in Z in place */
+	const struct znat_s *n = (const void*)z->hdr;
+	const struct zih_s *h = (const void*)(n + 1);
+	struct zif_s *res;
+
+	if (UNLIKELY(z->mpsz < sizeof(*n) + sizeof(*h))) {
+		return NULL;
+	} else if (UNLIKELY(n->bom != TZN_BOM ||
+			    n->zrsz != sizeof(n->rule) ||
+			    n->nbkt != ZIDX_NBKT)) {
+		/* compiled elsewhere */
+		return NULL;
+	} else if (UNLIKELY(n->isz != z->mpsz - sizeof(*n) ||
+			    memcmp(h->tzh_magic, TZ_MAGIC, 4U) ||
+			    __zif_isz(h) != n->isz || !h->tzh_typecnt)) {
+		/* truncated or garbage */
+		return NULL;
+	}
+
+	res = mmap(NULL, sizeof(*res), PROT_MEMMAP, MAP_MEMMAP, -1, 0);
+	if (UNLIKELY(res == MAP_FAILED)) {
+		return NULL;
+	}
+	res->mpsz = sizeof(*res) + n->isz;
+	res->hdr = deconst(h);
+	res->fd = -1;
+	res->cz = z->cz;
+	res->natp = 1U;
+	res->rulep = !!n->rulep;
+	res->rule = n->rule;
+	res->zid = __atomic_add_fetch(&zid_last, 1U, __ATOMIC_RELAXED);
 	__init_zif(res);
+	res->ibase = n->ibase;
+	res->ishft = n->ishft;
+
+	/* it's straight from the file, so check before use */
+	if (UNLIKELY(!__nat_valid_p(res))) {
+		munmap(res, sizeof(*res));
+		return NULL;
+	}
 	return res;
 }
 
@@ -509,6 +965,12 @@ __close(const struct zif_s z[static 1U])
 	if (z->hdr == MAP_FAILED) {
 		/* not sure what to do */
 		;
+	} else if (z->natp) {
+		/* the file is mapped from its header on, z on its own */
+		const size_t fsz = z->mpsz - sizeof(*z) + sizeof(struct znat_s);
+
+		munmap((char*)z->hdr - sizeof(struct znat_s), fsz);
+		munmap(deconst(z), sizeof(*z));
 	} else if ((z + 1) != (void*)z->hdr) {
 		/* z->hdr is mmapped, z is not */
 		munmap((void*)z->hdr, z->mpsz);
@@ -534,7 +996,7 @@ zif_open(const char *file)
 {
 	coord_zone_t cz;
 	int fd;
-	struct zif_s tmp[1];
+	struct zif_s tmp[1] = {{0U}};
 	struct zif_s *res;
 
 	/* check for special time zones */
@@ -546,7 +1008,16 @@ zif_open(const char *file)
 	if (UNLIKELY((fd = __open_zif(file)) < STDIN_FILENO)) {
 		return NULL;
 	} else if (UNLIKELY(__read_zif(tmp, fd) < 0)) {
+		close(fd);
 		return NULL;
+	} else if (!memcmp(tmp->hdr->tzh_magic, TZN_MAGIC, 4U)) {
+		/* precompiled, no conversions necessary, keep the mapping */
+		tmp->cz = cz;
+		close(fd);
+		if (UNLIKELY((res = __open_nat(tmp)) == NULL)) {
+			munmap(tmp->hdr, tmp->mpsz);
+		}
+		return res;
 	}
 	/* otherwise all's fine, it's still BE
 	 * assign the coord zone type if any and convert to host byte-order */
@@ -556,45 +1027,70 @@ zif_open(const char *file)
 	return res;
 }
 
+DEFUN int
+zif_write(zif_t z, int fd)
+{
+/* write Z to FD in native zone format */
+	struct znat_s n = {
+		.magic = TZN_MAGIC,
+		.bom = TZN_BOM,
+		.isz = z->mpsz - sizeof(*z),
+		.zrsz = sizeof(n.rule),
+		.nbkt = ZIDX_NBKT,
+		.rulep = z->rulep,
+		.ibase = z->ibase,
+		.ishft = z->ishft,
+		.rule = z->rule,
+	};
+	const char *p[] = {(const void*)&n, (const void*)z->hdr};
+	size_t z_[] = {sizeof(n), n.isz};
+
+	if (UNLIKELY(z->fd > STDIN_FILENO)) {
+		/* still in file byte-order */
+		return -1;
+	}
+	for (size_t i = 0U; i < countof(p); i++) {
+		for (ssize_t nwr; z_[i] > 0U; p[i] += nwr, z_[i] -= nwr) {
+			if ((nwr = write(fd, p[i], z_[i])) <= 0) {
+				return -1;
+			}
+		}
+	}
+	return 0;
+}
+
 
 /* for leap corrections */
 #include "leap-seconds.def"
 
 static inline int
-__find_trno(const struct zif_s z[static 1U], int32_t t, int min, int max)
+__find_trno(const struct zif_s z[static 1U], int64_t t, int min, int max)
 {
 /* find the last transition before T, T is expected to be UTC
- * if T is before any known transition return -1 */
-	if (UNLIKELY(max == 0)) {
+ * if T is before any known transition return -1
+ * transitions are sought in [MIN, MAX) and T must be before the MAX-th */
+	if (UNLIKELY(max <= min)) {
 		/* special case */
 		return -1;
-	} else if (UNLIKELY(t < zif_trans(z, min))) {
+	} else if (UNLIKELY(t < z->trs[min])) {
 		return -1;
-	} else if (UNLIKELY(t > zif_trans(z, max))) {
-		return max - 1;
 	}
 
-	do {
-		int32_t tl, tu;
-		int this = (min + max) / 2;
-
-		tl = zif_trans(z, this);
-		tu = zif_trans(z, this + 1);
+	/* trs[min] <= t and t < trs[max] or max == ntr */
+	while (max - min > 1) {
+		int this = min + (max - min) / 2;
 
-		if (t >= tl && t < tu) {
-			/* found him */
-			return this;
-		} else if (t >= tu) {
+		if (t >= z->trs[this]) {
 			min = this;
-		} else if (t < tl) {
+		} else {
 			max = this;
 		}
-	} while (true);
-	/* not reached */
+	}
+	return min;
 }
 
 DEFUN inline int
-zif_find_trans(zif_t z, int32_t t)
+zif_find_trans64(zif_t z, int64_t t)
 {
 /* find the last transition before T, T is expected to be UTC
  * if T is before any known transition return -1 */
@@ -604,38 +1100,168 @@ zif_find_trans(zif_t z, int32_t t)
 	return __find_trno(z, t, min, max);
 }
 
-static struct zrng_s
-__find_zrng(const struct zif_s z[static 1U], int32_t t, int min, int max)
+DEFUN int
+zif_find_trans(zif_t z, int32_t t)
 {
-	struct zrng_s res;
+	return zif_find_trans64(z, t);
+}
+
+static inline int64_t
+__fdiv(int64_t x, int64_t y)
+{
+/* floored division */
+	return x / y - (x % y < 0);
+}
+
+static int64_t
+__jan01(int64_t y)
+{
+/* days since the epoch of Y-01-01 in the proleptic Gregorian calendar */
+	y--;
+	return 365 * y + __fdiv(y, 4) - __fdiv(y, 100) + __fdiv(y, 400) -
+		719162;
+}
+
+static int64_t
+__year(int64_t t)
+{
+/* the Gregorian year stamp T falls in */
+	int64_t d = __fdiv(t, 86400);
+	/* estimate with the mean year length, then correct */
+	int64_t y = 1970 + __fdiv(d * 400, 146097);
+
+	for (; __jan01(y) > d; y--);
+	for (; __jan01(y + 1) <= d; y++);
+	return y;
+}
+
+static int64_t
+__rule_trans(int64_t y, struct zrdat_s r, int32_t offs)
+{
+/* return the transition R in year Y as UTC stamp, OFFS is the offset
+ * in effect before */
+	static const uint16_t cum[] = {
+		0U, 31U, 59U, 90U, 120U, 151U, 181U, 212U, 243U, 273U, 304U, 334U,
+		365U,
+	};
+	bool leapp = !(y % 4) && ((y % 100) || !(y % 400));
+	int64_t j = __jan01(y);
+	int64_t d;
+
+	switch (r.typ) {
+	case ZRD_J1:
+		d = r.d - 1 + (leapp && r.d >= 60U);
+		break;
+	default:
+	case ZRD_J0:
+		d = r.d;
+		break;
+	case ZRD_MWD: {
+		int64_t m1 = cum[r.m - 1U] + (leapp && r.m > 2U);
+		int64_t md = cum[r.m] - cum[r.m - 1U] + (leapp && r.m == 2U);
+		/* 1970-01-01 was a Thursday */
+		int64_t wd = (j + m1 + 4) - __fdiv(j + m1 + 4, 7) * 7;
+
+		d = (r.d + 7 - wd) % 7 + 7 * (r.w - 1U);
+		if (d >= md) {
+			d -= 7;
+		}
+		d += m1;
+		break;
+	}
+	}
+	return (j + d) * 86400 + r.secs - offs;
+}
+
+static struct zrng64_s
+__rule_zrng(const struct zif_s z[static 1U], int64_t t)
+{
+/* find the range T belongs to using Z's rule */
+	const size_t ntr = zif_ntrans(z);
+	struct zrng64_s res = {
+		.prev = ntr ? z->trs[ntr - 1U] : INT64_MIN,
+		.next = INT64_MAX,
+		.offs = z->rule.std,
+		.trno = (int32_t)ntr - 1,
+	};
+
+	if (z->rule.dstp) {
+		/* transitions of the years around T and the offsets after */
+		int64_t y = __year(t + z->rule.std);
+		int64_t tr[6U];
+		int32_t of[6U];
+		size_t n = 0U;
+		size_t i;
+
+		for (int64_t x = y - 1; x <= y + 1; x++) {
+			int64_t b = __rule_trans(x, z->rule.beg, z->rule.std);
+			int64_t e = __rule_trans(x, z->rule.end, z->rule.dst);
+
+			/* insertion sort, they're nearly in order */
+			for (i = n; i > 0U && tr[i - 1U] > b; i--) {
+				tr[i] = tr[i - 1U], of[i] = of[i - 1U];
+			}
+			tr[i] = b, of[i] = z->rule.dst, n++;
+			for (i = n; i > 0U && tr[i - 1U] > e; i--) {
+				tr[i] = tr[i - 1U], of[i] = of[i - 1U];
+			}
+			tr[i] = e, of[i] = z->rule.std, n++;
+		}
+		/* T lies within the middle year so there's a bracket */
+		for (i = 1U; i < n - 1U && tr[i] <= t; i++);
+		res.offs = of[i - 1U];
+		res.next = tr[i];
+		if (tr[i - 1U] > res.prev) {
+			res.prev = tr[i - 1U];
+		}
+	}
+	return res;
+}
+
+static struct zrng64_s
+__find_zrng(const struct zif_s z[static 1U], int64_t t, int min, int max)
+{
+	struct zrng64_s res;
 	int trno;
 
+	if (z->rulep) {
+		size_t ntr = zif_ntrans(z);
+
+		if (!ntr || t >= z->trs[ntr - 1U]) {
+			/* beyond what's stored, use the rule */
+			return __rule_zrng(z, t);
+		}
+	}
+	if (z->idx != NULL && t >= z->ibase && t < z->trs[zif_ntrans(z) - 1U]) {
+		/* the bucket narrows it down to a handful of transitions */
+		size_t i = ((uint64_t)t - (uint64_t)z->ibase) >> z->ishft;
+
+		min = z->idx[i] - 1;
+		max = z->idx[i + 1U];
+	}
 	trno = __find_trno(z, t, min, max);
-	res.prev = zif_trans(z, trno);
-	if (UNLIKELY(trno <= 0 && t < res.prev)) {
-		res.trno = 0U;
-		res.prev = INT_MIN;
-		/* assume the first offset has always been there */
-		res.next = res.prev;
-	} else if (UNLIKELY(trno < 0)) {
-		/* special case where no transitions are recorded */
-		res.trno = 0U;
-		res.prev = INT_MIN;
-		res.next = INT_MAX;
+	if (UNLIKELY(trno < 0)) {
+		/* before the first transition (or there are none),
+		 * the first type is in effect then */
+		res.trno = -1;
+		res.prev = INT64_MIN;
+		res.next = zif_ntrans(z) ? z->trs[0U] : INT64_MAX;
+		res.offs = z->tda[0U].offs;
+		return res;
+	}
+	res.trno = trno;
+	res.prev = z->trs[trno];
+	if (LIKELY(trno + 1U < zif_ntrans(z))) {
+		res.next = z->trs[trno + 1U];
 	} else {
-		res.trno = (uint8_t)trno;
-		if (LIKELY(trno + 1U < zif_ntrans(z))) {
-			res.next = zif_trans(z, trno + 1U);
-		} else {
-			res.next = INT_MAX;
-		}
+		res.next = INT64_MAX;
 	}
-	res.offs = zif_troffs(z, res.trno);
+	res.offs = zif_troffs(z, trno);
 	return res;
 }
 
-DEFUN inline struct zrng_s
-zif_find_zrng(zif_t z, int32_t t)
+DEFUN inline struct zrng64_s
+zif_find_zrng64(zif_t z, int64_t t)
 {
 /* find the last transition before time, time is expected to be UTC */
 	int max = zif_ntrans(z);
@@ -644,17 +1270,60 @@ zif_find_zrng(zif_t z, int32_t t)
 	return __find_zrng(z, t, min, max);
 }
 
+DEFUN struct zrng_s
+zif_find_zrng(zif_t z, int32_t t)
+{
+	struct zrng64_s r = zif_find_zrng64(z, t);
+	struct zrng_s res;
+
+	res.prev = r.prev > INT_MIN ? (int32_t)r.prev : INT_MIN;
+	res.next = r.next < INT_MAX ? (int32_t)r.next : INT_MAX;
+	res.offs = r.offs;
+	res.trno = r.trno > 0 ? (unsigned int)r.trno : 0U;
+	return res;
+}
+
+DEFUN void
+zif_trit_init(struct ztrit_s *it, zif_t z, int64_t t, int64_t stop)
+{
+	it->z = z;
+	it->stop = stop;
+	/* the range just before T ends with the transition we want */
+	t -= t > INT64_MIN;
+	it->r = __find_zrng(z, t, 0, zif_ntrans(z));
+	return;
+}
+
+DEFUN int
+zif_trit_next(struct ztrit_s *it, struct ztr64_s *tr)
+{
+	const int64_t t = it->r.next;
+	struct zrng64_s nx;
+
+	if (t >= it->stop || t == INT64_MAX) {
+		return -1;
+	}
+	nx = __find_zrng(it->z, t, 0, zif_ntrans(it->z));
+	*tr = (struct ztr64_s){t, it->r.offs, nx.offs};
+	if (UNLIKELY(nx.next <= t)) {
+		/* no progress, so no more transitions */
+		nx.next = INT64_MAX;
+	}
+	it->r = nx;
+	return 0;
+}
+
 static int32_t
-__tai_offs(int32_t t)
+__tai_offs(int64_t t)
 {
 	/* difference of TAI and UTC at epoch instant */
-	zidx_t zi = leaps_before_si32(leaps_s, nleaps_corr, t);
+	zidx_t zi = leaps_sidx_si64(leaps_sidx, nleaps_sidx, t);
 
 	return leaps_corr[zi];
 }
 
 static int32_t
-__gps_offs(int32_t t)
+__gps_offs(int64_t t)
 {
 /* TAI - GPS = 19 on 1980-01-06, so use that identity here */
 	const int32_t gps_offs_epoch = 19;
@@ -664,10 +1333,28 @@ __gps_offs(int32_t t)
 	return __tai_offs(t) - gps_offs_epoch;
 }
 
+static struct zrng64_s*
+__zcur(const struct zif_s z[static 1U])
+{
+/* return the calling thread's cursor for Z */
+	size_t i;
+
+	for (i = 0U; i < countof(zcur); i++) {
+		if (zcur[i].zid == z->zid) {
+			return &zcur[i].cur;
+		}
+	}
+	/* not seen by this thread yet, recycle a slot */
+	i = zcur_evict++ % countof(zcur);
+	zcur[i].zid = z->zid;
+	zcur[i].cur = (struct zrng64_s)ZIF_CUR_INIT;
+	return &zcur[i].cur;
+}
+
 static int32_t
-__offs(struct zif_s z[static 1U], int32_t t)
+__offs(const struct zif_s z[static 1U], struct zrng64_s *cur, int64_t t)
 {
-/* return the offset of T in Z and cache the result. */
+/* return the offset of T in Z and remember the range in CUR. */
 	int min;
 	size_t max;
 
@@ -684,25 +1371,25 @@ __offs(struct zif_s z[static 1U], int32_t t)
 	}
 
 	/* use the classic code */
-	if (LIKELY(t >= z->cache.prev && t < z->cache.next)) {
+	if (LIKELY(t >= cur->prev && t < cur->next)) {
 		/* use the cached offset */
-		return z->cache.offs;
-	} else if (t >= z->cache.next) {
-		min = z->cache.trno + 1;
+		return cur->offs;
+	} else if (t >= cur->next) {
+		min = cur->trno + 1;
 		max = zif_ntrans(z);
-	} else if (t < z->cache.prev) {
-		max = z->cache.trno;
+	} else if (t < cur->prev) {
+		max = cur->trno;
 		min = 0;
 	} else {
 		/* we shouldn't end up here at all */
 		min = 0;
 		max = 0;
 	}
-	return (z->cache = __find_zrng(z, t, min, max)).offs;
+	return (*cur = __find_zrng(z, t, min, max)).offs;
 }
 
-DEFUN int32_t
-zif_utc_time(zif_t z, int32_t t)
+DEFUN int64_t
+zif_utc_time_r(zif_t z, struct zrng64_s *cur, int64_t t)
 {
 /* here's the setup, given t in local time, we denote the corresponding
  * UTC time by t' = t - x' where x' is the true offset
@@ -713,7 +1400,6 @@ zif_utc_time(zif_t z, int32_t t)
  * To make this iterative we just solve:
  * x_{i+1} - x_i = 0, where x_{i+1} = o(t - x_i) and o maps a given
  * time stamp to an offset. */
-/* make me use the cache please! */
 	/* let's go */
 	int32_t xi = 0;
 	int32_t xj;
@@ -724,21 +1410,130 @@ zif_utc_time(zif_t z, int32_t t)
 		return t;
 	}
 
-	while ((xj = __offs(AS_MUT_ZIF(z), t - xi)) != xi && xi != old) {
+	while ((xj = __offs(z, cur, t - xi)) != xi && xi != old) {
 		old = xi = xj;
 	}
 	return t - xj;
 }
 
 /* convert utc to local */
-DEFUN int32_t
-zif_local_time(zif_t z, int32_t t)
+DEFUN int64_t
+zif_local_time_r(zif_t z, struct zrng64_s *cur, int64_t t)
 {
 	/* jump off the cliff if Z is nought */
 	if (UNLIKELY(z == NULL)) {
 		return t;
 	}
-	return t + __offs(AS_MUT_ZIF(z), t);
+	return t + __offs(z, cur, t);
+}
+
+DEFUN int64_t
+zif_utc_time64(zif_t z, int64_t t)
+{
+	if (UNLIKELY(z == NULL)) {
+		return t;
+	}
+	return zif_utc_time_r(z, __zcur(z), t);
+}
+
+DEFUN int64_t
+zif_local_time64(zif_t z, int64_t t)
+{
+	if (UNLIKELY(z == NULL)) {
+		return t;
+	}
+	return zif_local_time_r(z, __zcur(z), t);
+}
+
+/* batch conversions, runs of stamps within one range get the same
+ * offset, in blocks of ZVEC_BLK so that compilers can vectorise */
+#define ZVEC_BLK	(8U)
+
+static size_t
+__zvec_run(const int64_t *in, size_t i, size_t n, int64_t lo, int64_t hi)
+{
+/* return the end of the run of IN[I..N) that lies in [LO, HI) */
+	for (; i + ZVEC_BLK <= n; i += ZVEC_BLK) {
+		unsigned int m = 0U;
+
+		for (size_t k = 0U; k < ZVEC_BLK; k++) {
+			m |= (in[i + k] < lo) | (in[i + k] >= hi);
+		}
+		if (m) {
+			break;
+		}
+	}
+	for (; i < n && in[i] >= lo && in[i] < hi; i++);
+	return i;
+}
+
+DEFUN void
+zif_local_time_v(zif_t z, const int64_t *in, int64_t *out, size_t n)
+{
+	struct zrng64_s *cur;
+
+	if (UNLIKELY(z == NULL)) {
+		memmove(out, in, n * sizeof(*out));
+		return;
+	}
+	cur = __zcur(z);
+	for (size_t i = 0U; i < n;) {
+		const int32_t o = __offs(z, cur, in[i]);
+		/* coordinated zones leave the cursor alone */
+		size_t j = z->cz > TZCZ_UNK
+			? i + 1U : __zvec_run(in, i + 1U, n, cur->prev, cur->next);
+
+		for (; i < j; i++) {
+			out[i] = in[i] + o;
+		}
+	}
+	return;
+}
+
+DEFUN void
+zif_utc_time_v(zif_t z, const int64_t *in, int64_t *out, size_t n)
+{
+	struct zrng64_s *cur;
+
+	if (UNLIKELY(z == NULL)) {
+		memmove(out, in, n * sizeof(*out));
+		return;
+	}
+	cur = __zcur(z);
+	for (size_t i = 0U; i < n;) {
+		const int64_t t = zif_utc_time_r(z, cur, in[i]);
+		int32_t o;
+		int64_t lo, hi;
+		size_t j;
+
+		if (z->cz > TZCZ_UNK) {
+			out[i++] = t;
+			continue;
+		}
+		/* local stamps L with both L and L - O in the cursor's
+		 * range are unambiguous and map to L - O */
+		o = cur->offs;
+		lo = cur->prev + (o > 0 ? o : 0);
+		hi = cur->next + (o < 0 ? o : 0);
+		j = in[i] >= lo && in[i] < hi
+			? __zvec_run(in, i + 1U, n, lo, hi) : i + 1U;
+		for (out[i++] = t; i < j; i++) {
+			out[i] = in[i] - o;
+		}
+	}
+	return;
+}
+
+DEFUN int32_t
+zif_utc_time(zif_t z, int32_t t)
+{
+	return (int32_t)zif_utc_time64(z, t);
+}
+
+DEFUN int32_t
+zif_local_time(zif_t z, int32_t t)
+{
+	return (int32_t)zif_local_time64(z, t);
 }
 
 #endif	/* INCLUDED_tzraw_c_ */
@@ -119,6 +119,29 @@ struct zrng_s {
 	unsigned int trno:8;
 } __attribute__((packed));
 
+/* same with 64bit stamps, TRNO is -1 before the first transition */
+struct zrng64_s {
+	int64_t prev, next;
+	int32_t offs;
+	int32_t trno;
+};
+
+/* an empty range, use it to initialise lookup cursors */
+#define ZIF_CUR_INIT	{INT64_MIN, INT64_MIN, 0, -1}
+
+/* a transition at T (UTC) from offset FROM to offset TO */
+struct ztr64_s {
+	int64_t t;
+	int32_t from, to;
+};
+
+/* transition iterator, see zif_trit_init() */
+struct ztrit_s {
+	zif_t z;
+	int64_t stop;
+	struct zrng64_s r;
+};
+
 
 /**
  * Open the zoneinfo file FILE.
@@ -136,21 +159,70 @@ extern zif_t zif_copy(zif_t);
 
 /**
  * Find the most recent transition in Z before T. */
-extern int zif_find_trans(zif_t z, int32_t t);
+extern int zif_find_trans64(zif_t z, int64_t t);
 
 /**
  * Find a range of transitions in Z that T belongs to. */
-extern struct zrng_s zif_find_zrng(zif_t z, int32_t t);
+extern struct zrng64_s zif_find_zrng64(zif_t z, int64_t t);
+
+/**
+ * Position IT at the first transition in Z at or after T,
+ * iteration ends before the first transition at or after STOP. */
+extern void
+zif_trit_init(struct ztrit_s *it, zif_t z, int64_t t, int64_t stop);
+
+/**
+ * Store the current transition of IT in TR and advance.
+ * Transitions come from the stored table first and then from
+ * the zone's rule.  Return 0 on success or -1 if IT is exhausted. */
+extern int zif_trit_next(struct ztrit_s *it, struct ztr64_s *tr);
 
 /**
  * Given T in local time specified by Z, return a T in UTC. */
-extern int32_t zif_utc_time(zif_t z, int32_t t);
+extern int64_t zif_utc_time64(zif_t z, int64_t t);
 
 /**
  * Given T in UTC, return a T in local time specified by Z. */
+extern int64_t zif_local_time64(zif_t z, int64_t t);
+
+/**
+ * Like zif_utc_time64() and zif_local_time64() but remember the last
+ * range looked up in CUR instead of a per-thread slot.
+ * Zones themselves are never written to, so they can be shared between
+ * threads as long as each thread brings its own cursor.
+ * CUR must be initialised with ZIF_CUR_INIT and used with Z only. */
+extern int64_t zif_utc_time_r(zif_t z, struct zrng64_s *cur, int64_t t);
+
+extern int64_t zif_local_time_r(zif_t z, struct zrng64_s *cur, int64_t t);
+
+/**
+ * Convert the N UTC stamps IN to local time in Z, store them in OUT.
+ * OUT may equal IN, sorted or clustered input is converted fastest. */
+extern void
+zif_local_time_v(zif_t z, const int64_t *in, int64_t *out, size_t n);
+
+/**
+ * Convert the N local stamps IN in Z to UTC, store them in OUT.
+ * OUT may equal IN, results agree with zif_utc_time64(). */
+extern void
+zif_utc_time_v(zif_t z, const int64_t *in, int64_t *out, size_t n);
+
+/* 32bit versions of the above */
+extern int zif_find_trans(zif_t z, int32_t t);
+
+extern struct zrng_s zif_find_zrng(zif_t z, int32_t t);
+
+extern int32_t zif_utc_time(zif_t z, int32_t t);
+
 extern int32_t zif_local_time(zif_t z, int32_t t);
 
 
+/**
+ * Write Z to file descriptor FD in native zone format.
+ * Native zone files are mapped and used as is by zif_open().
+ * Return 0 on success and -1 otherwise. */
+extern int zif_write(zif_t z, int fd);
+
 /* exposure for specific zif-inspecting tools (dzone(1) for one) */
 extern size_t zif_ntrans(zif_t z);
 
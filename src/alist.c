@@ -39,38 +39,88 @@
 #endif	/* HAVE_CONFIG_H */
 #include <stddef.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
 #include "alist.h"
 #include "nifty.h"
 
 /* our alist is a simple flat char array with pointers behind every key
- * aligned to void* boundaries. */
+ * aligned to void* boundaries, keys are found through an open-addressing
+ * hash index over their offsets. */
+
+static inline size_t
+__hash(const char *key)
+{
+/* 32bit FNV-1a */
+	uint_fast32_t h = 2166136261U;
+
+	for (; *key; key++) {
+		h ^= (unsigned char)*key;
+		h *= 16777619U;
+		h &= 0xffffffffU;
+	}
+	return h;
+}
+
+static inline const void**
+__val(alist_t al, size_t off, size_t klen)
+{
+/* the value slot behind the key at OFF */
+	return (const void**)al->data + (off + klen) / sizeof(void*) + 1U;
+}
 
 static const void**
 __assoc(alist_t al, const char *key)
 {
-	for (const char *ap = al->data, *const ep = ap + al->dend; ap < ep;) {
+	if (UNLIKELY(al->hidx == NULL)) {
+		return NULL;
+	}
+	for (size_t i = __hash(key);; i++) {
+		size_t o = al->hidx[i &= al->hnsl - 1U];
 		const char *kp;
-		const void **res = (const void**)al->data;
 
-		/* unrolled strcmp */
-		for (kp = key; *ap && *ap == *kp; ap++, kp++);
+		if (!o--) {
+			/* empty slot */
+			break;
+		} else if (!strcmp(kp = al->data + o, key)) {
+			return __val(al, o, strlen(kp));
+		}
+	}
+	return NULL;
+}
+
+static int
+__hidx_add(alist_t al, const char *key, size_t off)
+{
+	/* keep the load factor at or below 1/2 */
+	if (UNLIKELY(2U * (al->nkey + 1U) > al->hnsl)) {
+		size_t nsl = al->hnsl * 2U ?: 16U;
+		size_t *tmp;
 
-		/* fast forward to void** boundary */
-		res += (ap - al->data) / sizeof(res) + 1U;
+		if (UNLIKELY((tmp = calloc(nsl, sizeof(*tmp))) == NULL)) {
+			return -1;
+		}
+		for (size_t i = 0U; i < al->hnsl; i++) {
+			size_t o = al->hidx[i];
+
+			if (o) {
+				size_t j = __hash(al->data + o - 1U);
 
-		if (*ap == *kp) {
-			/* match! invariant: ap == kp == '\0' */
-			return res;
-		} else if (*ap) {
-			/* fast forward in void** increments */
-			for (; ((const char*)res)[-1]; res++);
+				for (; tmp[j &= nsl - 1U]; j++);
+				tmp[j] = o;
+			}
 		}
-		/* skip over ptr, start again */
-		ap = (const char*)++res;
+		free(al->hidx);
+		al->hidx = tmp;
+		al->hnsl = nsl;
 	}
-	return NULL;
+	with (size_t i = __hash(key)) {
+		for (; al->hidx[i &= al->hnsl - 1U]; i++);
+		al->hidx[i] = off + 1U;
+	}
+	al->nkey++;
+	return 0;
 }
 
 static bool
@@ -83,16 +133,22 @@ static int
 __chk_resz(alist_t al, size_t keylen)
 {
 	if (UNLIKELY(!__fitsp(al, keylen))) {
-		size_t ol = al->allz;
+		size_t nu = al->allz ?: 32U;
 		void *tmp;
 
-		al->allz = (al->allz * 2U) ?: 64U;
-		if (UNLIKELY((tmp = realloc(al->data, al->allz)) == NULL)) {
+		/* long keys may need more than one doubling */
+		do {
+			nu *= 2U;
+		} while (al->dend + keylen + 2 * sizeof(void**) >= nu);
+		/* only commit to the new size once we've got it, the
+		 * next put would write through a NULL buffer otherwise */
+		if (UNLIKELY((tmp = realloc(al->data, nu)) == NULL)) {
 			free_alist(al);
 			return -1;
 		}
 		al->data = tmp;
-		memset(al->data + ol, 0, al->allz - ol);
+		memset(al->data + al->allz, 0, nu - al->allz);
+		al->allz = nu;
 	}
 	return 0;
 }
@@ -104,6 +160,7 @@ free_alist(alist_t al)
 {
 	if (LIKELY(al->data != NULL)) {
 		free(al->data);
+		free(al->hidx);
 		memset(al, 0, sizeof(*al));
 	}
 	return;
@@ -129,11 +186,17 @@ alist_put(alist_t al, const char *key, const void *val)
 {
 	size_t klen = strlen(key);
 
-	__chk_resz(al, klen);
+	if (UNLIKELY(__chk_resz(al, klen) < 0)) {
+		return;
+	}
 	memcpy(al->data + al->dend, key, klen);
+	if (UNLIKELY(__hidx_add(al, key, al->dend) < 0)) {
+		/* just forget about KEY */
+		memset(al->data + al->dend, 0, klen);
+		return;
+	}
 	/* round up to void** boundary */
-	with (const void **data = (const void**)al->data) {
-		data += (al->dend + klen) / sizeof(data) + 1U;
+	with (const void **data = __val(al, al->dend, klen)) {
 		*data++ = val;
 		al->dend = (const char*)data - al->data;
 	}
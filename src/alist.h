@@ -47,6 +47,10 @@ struct alist_s {
 	/* private slots */
 	size_t dend;
 	const void *iter;
+	/* hash index, slots hold 1 + the offset of a key in DATA */
+	size_t *hidx;
+	size_t hnsl;
+	size_t nkey;
 };
 
 struct acons_s {
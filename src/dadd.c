@@ -45,6 +45,7 @@
 
 #include "dt-core.h"
 #include "dt-io.h"
+#include "dt-io-par.h"
 #include "dt-core-tz-glue.h"
 #include "dt-locale.h"
 #include "prchunk.h"
@@ -87,7 +88,9 @@ struct mass_add_clo_s {
 };
 
 static int
-proc_line(const struct mass_add_clo_s *clo, char *line, size_t llen)
+proc_line(
+	const struct mass_add_clo_s *clo, dt_io_obuf_t ob,
+	char *line, size_t llen)
 {
 	struct dt_dt_s d;
 	char *sp = NULL;
@@ -112,17 +115,17 @@ proc_line(const struct mass_add_clo_s *clo, char *line, size_t llen)
 			}
 
 			if (clo->sed_mode_p) {
-				__io_write(line, sp - line, stdout);
-				dt_io_write(d, clo->ofmt, clo->z, '\0');
+				__io_bwrite(line, sp - line, ob);
+				dt_io_bwrite(d, clo->ofmt, clo->z, '\0', ob);
 				llen -= (ep - line);
 				line = ep;
 			} else {
-				dt_io_write(d, clo->ofmt, clo->z, '\n');
+				dt_io_bwrite(d, clo->ofmt, clo->z, '\n', ob);
 				break;
 			}
 		} else if (clo->sed_mode_p) {
 			line[llen] = '\n';
-			__io_write(line, llen + 1, stdout);
+			__io_bwrite(line, llen + 1, ob);
 			break;
 		} else {
 			/* obviously unmatched, warn about it in non -q mode */
@@ -136,6 +139,12 @@ proc_line(const struct mass_add_clo_s *clo, char *line, size_t llen)
 	return rc;
 }
 
+static int
+proc_line_par(void *clo, dt_io_obuf_t ob, char *line, size_t llen)
+{
+	return proc_line(clo, ob, line, llen);
+}
+
 static int
 mass_add_dur(const struct mass_add_clo_s *clo)
 {
@@ -149,7 +158,7 @@ mass_add_dur(const struct mass_add_clo_s *clo)
 	for (char *line; prchunk_haslinep(clo->pctx); lno++) {
 		size_t llen = prchunk_getline(clo->pctx, &line);
 
-		rc |= proc_line(clo, line, llen);
+		rc |= proc_line(clo, NULL, line, llen);
 	}
 	return rc;
 }
@@ -197,7 +206,7 @@ mass_add_d(const struct mass_add_clo_s *clo)
 			/* no sed mode here */
 			dt_io_write(d, clo->ofmt, clo->z, '\n');
 		} else if (clo->sed_mode_p) {
-			__io_write(line, llen + 1, stdout);
+			dt_io_owrite(line, llen + 1);
 		} else if (!clo->quietp) {
 			line[llen] = '\0';
 			dt_io_warn_strpdt(line);
@@ -229,6 +238,7 @@ main(int argc, char *argv[])
 	zif_t z = NULL;
 	zif_t hackz = NULL;
 
+	dt_io_timing(NULL);
 	if (yuck_parse(argi, argc, argv)) {
 		rc = 1;
 		goto out;
@@ -248,6 +258,7 @@ main(int argc, char *argv[])
 			dt_io_unescape(fmt[i]);
 		}
 	}
+	dt_io_timing("options");
 
 	if (argi->from_locale_arg) {
 		setilocale(argi->from_locale_arg);
@@ -255,6 +266,7 @@ main(int argc, char *argv[])
 	if (argi->locale_arg) {
 		setflocale(argi->locale_arg);
 	}
+	dt_io_timing("locale");
 
 	/* try and read the from and to time zones */
 	if (argi->from_zone_arg) {
@@ -267,6 +279,7 @@ main(int argc, char *argv[])
 		struct dt_dt_s base = dt_strpdt(argi->base_arg, NULL, NULL);
 		dt_set_base(base);
 	}
+	dt_io_timing("zones");
 
 	/* sanity checks, decide whether we're a mass date adder
 	 * or a mass duration adder, or both, a date and durations are
@@ -363,9 +376,11 @@ Error: cannot interpret date/time string `%s'", inp);
 				dt_io_write(d, ofmt, z, '\n');
 				continue;
 			empty:
-				__io_write("\n", 1U, stdout);
+				dt_io_owrite("\n", 1U);
 			}
 		}
+		/* get rid of resources */
+		free_prchunk(pctx);
 	} else if (st.ndurs) {
 		/* read dates from stdin */
 		struct grep_atom_s __nstk[16], *needle = __nstk;
@@ -373,6 +388,8 @@ Error: cannot interpret date/time string `%s'", inp);
 		struct grep_atom_soa_s ndlsoa;
 		struct mass_add_clo_s clo[1];
 		void *pctx;
+		unsigned int njobs = dt_io_par_njobs(argi->jobs_arg);
+		dt_io_par_t par;
 
 		/* no threads reading this stream */
 		__io_setlocking_bycaller(stdout);
@@ -402,9 +419,26 @@ Error: cannot interpret date/time string `%s'", inp);
 		clo->ofmt = ofmt;
 		clo->sed_mode_p = argi->sed_mode_flag;
 		clo->quietp = argi->quiet_flag;
+		if (njobs > 1U && (par = dt_io_par_init(njobs)) != NULL) {
+			struct mass_add_clo_s pclo[njobs];
+			void *pclop[njobs];
+
+			/* zones are shared, lookups cache per thread */
+			for (unsigned int i = 0U; i < njobs; i++) {
+				pclo[i] = *clo;
+				pclop[i] = pclo + i;
+			}
+			while (prchunk_fill(pctx) >= 0) {
+				rc |= dt_io_par_proc(
+					par, pctx, proc_line_par, pclop);
+			}
+			dt_io_par_free(par);
+			goto prch_free;
+		}
 		while (prchunk_fill(pctx) >= 0) {
 			rc |= mass_add_dur(clo);
 		}
+	prch_free:
 		/* get rid of resources */
 		free_prchunk(pctx);
 	ndl_free:
@@ -442,6 +476,7 @@ Error: cannot interpret date/time string `%s'", inp);
 		free_prchunk(pctx);
 	}
 clear:
+	dt_io_timing("process");
 	/* free the strpdur status */
 	__strpdtdur_free(&st);
 
@@ -452,6 +487,7 @@ clear:
 	if (argi->locale_arg) {
 		setflocale(NULL);
 	}
+	dt_io_timing("cleanup");
 
 out:
 	yuck_free(argi);
@@ -45,6 +45,7 @@
 
 #include "dt-core.h"
 #include "dt-io.h"
+#include "dt-io-par.h"
 #include "dt-locale.h"
 #include "prchunk.h"
 
@@ -58,35 +59,64 @@ struct prln_ctx_s {
 	zif_t outz;
 	int sed_mode_p;
 	int quietp;
+	/* per-line source zones */
+	unsigned int zfld;
+	dt_io_zcache_t zc;
 };
 
+static zif_t
+line_zone(struct prln_ctx_s ctx, const char *line, size_t llen)
+{
+/* return the zone named in field ZFLD of LINE, or the default one */
+	const char *fp = line;
+	const char *const ep = line + llen;
+	const char *fe;
+
+	for (unsigned int i = 1U; i < ctx.zfld; i++, fp++) {
+		if ((fp = memchr(fp, '\t', ep - fp)) == NULL) {
+			return ctx.fromz;
+		}
+	}
+	if ((fe = memchr(fp, '\t', ep - fp)) == NULL) {
+		fe = ep;
+	}
+	if (fp >= fe) {
+		/* empty field */
+		return ctx.fromz;
+	}
+	return dt_io_zcache_get(ctx.zc, fp, fe - fp) ?: ctx.fromz;
+}
+
 static int
-proc_line(struct prln_ctx_s ctx, char *line, size_t llen)
+proc_line(struct prln_ctx_s ctx, dt_io_obuf_t ob, char *line, size_t llen)
 {
 	struct dt_dt_s d;
 	char *sp = NULL;
 	char *ep = NULL;
 	int rc = 0;
 
+	if (ctx.zfld) {
+		ctx.fromz = line_zone(ctx, line, llen);
+	}
 	do {
 		d = dt_io_find_strpdt2(
 			line, llen, ctx.ndl, &sp, &ep, ctx.fromz);
 
 		/* check if line matches */
 		if (!dt_unk_p(d) && ctx.sed_mode_p) {
-			__io_write(line, sp - line, stdout);
-			dt_io_write(d, ctx.ofmt, ctx.outz, '\0');
+			__io_bwrite(line, sp - line, ob);
+			dt_io_bwrite(d, ctx.ofmt, ctx.outz, '\0', ob);
 			llen -= (ep - line);
 			line = ep;
 		} else if (!dt_unk_p(d)) {
 			if (UNLIKELY(d.fix) && !ctx.quietp) {
 				rc = 2;
 			}
-			dt_io_write(d, ctx.ofmt, ctx.outz, '\n');
+			dt_io_bwrite(d, ctx.ofmt, ctx.outz, '\n', ob);
 			break;
 		} else if (ctx.sed_mode_p) {
 			line[llen] = '\n';
-			__io_write(line, llen + 1, stdout);
+			__io_bwrite(line, llen + 1, ob);
 			break;
 		} else {
 			/* obviously unmatched, warn about it in non -q mode */
@@ -100,6 +130,12 @@ proc_line(struct prln_ctx_s ctx, char *line, size_t llen)
 	return rc;
 }
 
+static int
+proc_line_par(void *clo, dt_io_obuf_t ob, char *line, size_t llen)
+{
+	return proc_line(*(const struct prln_ctx_s*)clo, ob, line, llen);
+}
+
 
 #include "dconv.yucc"
 
@@ -113,7 +149,9 @@ main(int argc, char *argv[])
 	int rc = 0;
 	zif_t fromz = NULL;
 	zif_t z = NULL;
+	unsigned int zfld = 0U;
 
+	dt_io_timing(NULL);
 	if (yuck_parse(argi, argc, argv)) {
 		rc = 1;
 		goto out;
@@ -128,6 +166,7 @@ main(int argc, char *argv[])
 			dt_io_unescape(fmt[i]);
 		}
 	}
+	dt_io_timing("options");
 
 	if (argi->locale_arg) {
 		setflocale(argi->locale_arg);
@@ -135,6 +174,7 @@ main(int argc, char *argv[])
 	if (argi->from_locale_arg) {
 		setilocale(argi->from_locale_arg);
 	}
+	dt_io_timing("locale");
 
 	/* try and read the from and to time zones */
 	if (argi->from_zone_arg) {
@@ -143,10 +183,26 @@ main(int argc, char *argv[])
 	if (argi->zone_arg) {
 		z = dt_io_zone(argi->zone_arg);
 	}
+	if (argi->zone_map_arg && dt_io_zone_map(argi->zone_map_arg) < 0) {
+		rc = 1;
+		goto clear;
+	}
+	if (argi->zone_field_arg) {
+		char *on;
+		long int f = strtol(argi->zone_field_arg, &on, 10);
+
+		if (*on || f <= 0 || f > 65535) {
+			error("Error: zone field must be a positive number");
+			rc = 1;
+			goto clear;
+		}
+		zfld = (unsigned int)f;
+	}
 	if (argi->base_arg) {
 		struct dt_dt_s base = dt_strpdt(argi->base_arg, NULL, NULL);
 		dt_set_base(base);
 	}
+	dt_io_timing("zones");
 
 	if (argi->nargs) {
 		for (size_t i = 0; i < argi->nargs; i++) {
@@ -195,7 +251,7 @@ main(int argc, char *argv[])
 				dt_io_write(d, ofmt, z, '\n');
 				continue;
 			empty:
-				__io_write("\n", 1U, stdout);
+				dt_io_owrite("\n", 1U);
 			}
 		}
 		/* get rid of resources */
@@ -207,6 +263,8 @@ main(int argc, char *argv[])
 		size_t nneedle = countof(__nstk);
 		struct grep_atom_soa_s ndlsoa;
 		void *pctx;
+		unsigned int njobs = dt_io_par_njobs(argi->jobs_arg);
+		dt_io_par_t par;
 		struct prln_ctx_s prln = {
 			.ndl = &ndlsoa,
 			.ofmt = ofmt,
@@ -214,6 +272,7 @@ main(int argc, char *argv[])
 			.outz = z,
 			.sed_mode_p = argi->sed_mode_flag,
 			.quietp = argi->quiet_flag,
+			.zfld = zfld,
 		};
 
 		/* no threads reading this stream */
@@ -233,13 +292,41 @@ main(int argc, char *argv[])
 			serror("Error: could not open stdin");
 			goto ndl_free;
 		}
+		if (njobs > 1U && (par = dt_io_par_init(njobs)) != NULL) {
+			struct prln_ctx_s clo[njobs];
+			void *clop[njobs];
+
+			/* zones are shared, lookups cache per thread */
+			for (unsigned int i = 0U; i < njobs; i++) {
+				clo[i] = prln;
+				if (prln.zfld) {
+					clo[i].zc = dt_io_zcache_init(
+						argi->zone_map_arg);
+				}
+				clop[i] = clo + i;
+			}
+			while (prchunk_fill(pctx) >= 0) {
+				rc |= dt_io_par_proc(
+					par, pctx, proc_line_par, clop);
+			}
+			dt_io_par_free(par);
+			for (unsigned int i = 0U; i < njobs; i++) {
+				dt_io_zcache_free(clo[i].zc);
+			}
+			goto prch_free;
+		}
+		if (prln.zfld) {
+			prln.zc = dt_io_zcache_init(argi->zone_map_arg);
+		}
 		while (prchunk_fill(pctx) >= 0) {
 			for (char *line; prchunk_haslinep(pctx); lno++) {
 				size_t llen = prchunk_getline(pctx, &line);
 
-				rc |= proc_line(prln, line, llen);
+				rc |= proc_line(prln, NULL, line, llen);
 			}
 		}
+		dt_io_zcache_free(prln.zc);
+	prch_free:
 		/* get rid of resources */
 		free_prchunk(pctx);
 	ndl_free:
@@ -249,6 +336,7 @@ main(int argc, char *argv[])
 	}
 
 clear:
+	dt_io_timing("process");
 	dt_io_clear_zones();
 	if (argi->from_locale_arg) {
 		setilocale(NULL);
@@ -256,6 +344,7 @@ clear:
 	if (argi->locale_arg) {
 		setflocale(NULL);
 	}
+	dt_io_timing("cleanup");
 
 out:
 	yuck_free(argi);
@@ -664,7 +664,7 @@ ddiff_prnt(struct dt_dtdur_s dur, const char *fmt, durfmt_t f, bool only_d_p)
 		buf[res++] = '\n';
 	}
 	if (res > 0) {
-		__io_write(buf, res, stdout);
+		dt_io_owrite(buf, res);
 	}
 	return (res > 0) - 1;
 }
@@ -790,7 +790,7 @@ main(int argc, char *argv[])
 					}
 					if (argi->empty_mode_flag) {
 						/* empty line */
-						__io_write("\n", 1U, stdout);
+						dt_io_owrite("\n", 1U);
 					}
 					continue;
 				} else if (UNLIKELY(d2.fix) &&
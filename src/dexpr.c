@@ -117,6 +117,7 @@ __pr_val(struct dexkv_s *kv)
 		break;
 	case DT_SPFL_N_MON:
 	case DT_SPFL_S_MON:
+		dut_need_ilocale();
 		if (kv->s >= 0 && kv->s <= 12) {
 			fputs(dut_abbr_mon[kv->s], stdout);
 		}
@@ -126,6 +127,7 @@ __pr_val(struct dexkv_s *kv)
 		break;
 	case DT_SPFL_N_DCNT_WEEK:
 	case DT_SPFL_S_WDAY:
+		dut_need_ilocale();
 		if (kv->s >= 0 && kv->s <= 7) {
 			fputs(dut_abbr_wday[kv->s], stdout);
 		}
@@ -610,7 +612,12 @@ __conj_matches_p(const_dexpr_t dex, struct dt_dt_s d)
 	const_dexpr_t a;
 
 	for (a = dex; a->type == DEX_CONJ; a = a->right) {
-		if (!dexkv_matches_p(a->left->kv, d)) {
+		/* a&&b&&c comes as (a&&b)&&c */
+		if (a->left->type == DEX_CONJ) {
+			if (!__conj_matches_p(a->left, d)) {
+				return false;
+			}
+		} else if (!dexkv_matches_p(a->left->kv, d)) {
 			return false;
 		}
 	}
@@ -624,7 +631,12 @@ __disj_matches_p(const_dexpr_t dex, struct dt_dt_s d)
 	const_dexpr_t o;
 
 	for (o = dex; o->type == DEX_DISJ; o = o->right) {
-		if (__conj_matches_p(o->left, d)) {
+		/* normal forms may come as (a||b)||c */
+		if (o->left->type == DEX_DISJ) {
+			if (__disj_matches_p(o->left, d)) {
+				return true;
+			}
+		} else if (__conj_matches_p(o->left, d)) {
 			return true;
 		}
 	}
@@ -638,6 +650,329 @@ dexpr_matches_p(const_dexpr_t dex, struct dt_dt_s d)
 	return __disj_matches_p(dex, d);
 }
 
+
+/* compiled dexprs */
+static inline int
+__sgnu(uint64_t a, uint64_t b)
+{
+	return (a > b) - (a < b);
+}
+
+static inline int
+__sgni(signed int a, signed int b)
+{
+	return (a > b) - (a < b);
+}
+
+static inline bool
+__dexcc_u_p(dt_dtyp_t typ)
+{
+/* whether dates of type TYP compare like their u slot */
+	switch (typ) {
+	case DT_YMD:
+	case DT_DAISY:
+	case DT_BIZDA:
+	case DT_YWD:
+	case DT_YD:
+		return true;
+	default:
+		break;
+	}
+	return false;
+}
+
+static struct dexcc_s
+__dexcc_kv(const_dexkv_t kv)
+{
+/* compile KV, mirroring dexkv_matches_p() */
+	static const unsigned char msk[8U] = {
+		[OP_EQ] = 0b010U,
+		[OP_LT] = 0b001U,
+		[OP_LE] = 0b011U,
+		[OP_GT] = 0b100U,
+		[OP_GE] = 0b110U,
+		[OP_NE] = 0b101U,
+		[OP_TRUE] = 0b111U,
+	};
+	struct dexcc_s res = {.key = DEXCC_GEN, .kv = kv};
+
+	if (kv->sp.spfl == DT_SPFL_N_STD) {
+		/* OP_UNK means OP_EQ here */
+		res.msk = msk[kv->op ?: OP_EQ];
+		if (dt_sandwich_only_d_p(kv->d)) {
+			if (__dexcc_u_p(kv->d.d.typ)) {
+				res.key = DEXCC_DU;
+				res.typ = kv->d.d.typ;
+				res.du = kv->d.d.u;
+			}
+		} else if (dt_sandwich_only_t_p(kv->d)) {
+			res.key = DEXCC_TU;
+			res.tu = kv->d.t.u;
+		} else if (dt_sandwich_p(kv->d) && __dexcc_u_p(kv->d.d.typ)) {
+			res.key = DEXCC_DTU;
+			res.typ = kv->d.typ;
+			res.du = kv->d.d.u;
+			res.tu = kv->d.t.hms.u;
+		}
+		return res;
+	}
+	/* S slot keys compare the cell against the stream */
+	res.msk = msk[kv->op];
+	res.s = kv->s;
+	switch (kv->sp.spfl) {
+	case DT_SPFL_N_YEAR:
+		res.key = DEXCC_YEAR;
+		break;
+	case DT_SPFL_N_MON:
+	case DT_SPFL_S_MON:
+		res.key = DEXCC_MON;
+		break;
+	case DT_SPFL_N_DCNT_MON:
+		res.key = DEXCC_MDAY;
+		break;
+	case DT_SPFL_N_DCNT_WEEK:
+	case DT_SPFL_S_WDAY:
+		res.key = DEXCC_WDAY;
+		break;
+	case DT_SPFL_N_WCNT_MON:
+		res.key = DEXCC_WCNT_MON;
+		break;
+	case DT_SPFL_N_DCNT_YEAR:
+		res.key = DEXCC_YDAY;
+		break;
+	case DT_SPFL_N_WCNT_YEAR:
+		res.key = DEXCC_WCNT_YEAR;
+		break;
+	default:
+		break;
+	}
+	return res;
+}
+
+static size_t
+__dexcc_cells(struct dexcc_s *restrict c, size_t i, const_dexpr_t dex)
+{
+/* compile the cells of conjunction DEX into C from I onwards,
+ * return the new I, C may be NULL to just count */
+	const_dexpr_t a;
+
+	for (a = dex; a->type == DEX_CONJ; a = a->right) {
+		/* a&&b&&c comes as (a&&b)&&c */
+		if (a->left->type == DEX_CONJ) {
+			i = __dexcc_cells(c, i, a->left);
+		} else if (c != NULL) {
+			c[i++] = __dexcc_kv(a->left->kv);
+		} else {
+			i++;
+		}
+	}
+	/* rightmost cell might be a DEX_VAL */
+	if (c != NULL) {
+		c[i] = __dexcc_kv(a->kv);
+	}
+	return i + 1U;
+}
+
+static size_t
+__dexcc_conj(struct dexcc_s *restrict c, size_t i, const_dexpr_t dex)
+{
+	const size_t beg = i;
+
+	i = __dexcc_cells(c, i, dex);
+	if (c != NULL) {
+		c[i - 1U].eoc = 1U;
+		for (size_t j = beg; j < i; j++) {
+			c[j].nxt = i;
+		}
+	}
+	return i;
+}
+
+static size_t
+__dexcc_disj(struct dexcc_s *restrict c, size_t i, const_dexpr_t dex)
+{
+	const_dexpr_t o;
+
+	for (o = dex; o->type == DEX_DISJ; o = o->right) {
+		/* normal forms may come as (a||b)||c */
+		if (o->left->type == DEX_DISJ) {
+			i = __dexcc_disj(c, i, o->left);
+		} else {
+			i = __dexcc_conj(c, i, o->left);
+		}
+	}
+	return __dexcc_conj(c, i, o);
+}
+
+static __attribute__((unused)) struct dexcc_s*
+dexpr_compile(const_dexpr_t root, size_t *nc)
+{
+/* turn the simplified ROOT into a list of checks, its length goes
+ * to NC, the checks refer to cells of ROOT so keep it around */
+	struct dexcc_s *res;
+	size_t n = __dexcc_disj(NULL, 0U, root);
+
+	if (UNLIKELY((res = calloc(n, sizeof(*res))) == NULL)) {
+		return NULL;
+	}
+	*nc = __dexcc_disj(res, 0U, root);
+	return res;
+}
+
+static inline bool
+__dexcc_check(
+	const struct dexcc_s *c, const struct dt_dt_s *d, struct dt_d_s dd)
+{
+/* check C against D whose date part is DD */
+	int cmp;
+
+	switch (c->key) {
+	case DEXCC_GEN:
+		return dexkv_matches_p(c->kv, *d);
+	case DEXCC_DU:
+		/* dates of different types never compare */
+		cmp = __sgnu(dd.u, c->du);
+		return (dd.typ == c->typ) & (c->msk >> (cmp + 1));
+	case DEXCC_TU:
+		cmp = __sgnu(d->t.u, c->tu);
+		break;
+	case DEXCC_DTU:
+		cmp = __sgnu(dd.u, c->du);
+		cmp += !cmp * __sgnu(d->t.hms.u, c->tu);
+		return (d->typ == c->typ) & (c->msk >> (cmp + 1));
+	case DEXCC_YEAR:
+		cmp = dd.typ == DT_YMD ? dd.ymd.y : dt_get_year(dd);
+		cmp = __sgni(c->s, cmp);
+		break;
+	case DEXCC_MON:
+		cmp = dd.typ == DT_YMD ? dd.ymd.m : dt_get_mon(dd);
+		cmp = __sgni(c->s, cmp);
+		break;
+	case DEXCC_MDAY:
+		cmp = dd.typ == DT_YMD ? dd.ymd.d : dt_get_mday(dd);
+		cmp = __sgni(c->s, cmp);
+		break;
+	case DEXCC_WDAY:
+		cmp = __sgni(c->s, dt_get_wday(dd));
+		break;
+	case DEXCC_WCNT_MON:
+		cmp = __sgni(c->s, dt_get_wcnt_mon(dd));
+		break;
+	case DEXCC_YDAY:
+		cmp = __sgni(c->s, dt_get_yday(dd));
+		break;
+	case DEXCC_WCNT_YEAR:
+		cmp = __sgni(c->s, dt_get_wcnt_year(dd, c->kv->sp.wk_cnt));
+		break;
+	default:
+		return false;
+	}
+	return (c->msk >> (cmp + 1)) & 0b1U;
+}
+
+static __attribute__((unused)) bool
+dexcc_matches_p(const struct dexcc_s *c, size_t nc, struct dt_dt_s d)
+{
+/* like dexpr_matches_p() but on the compiled form */
+	struct dt_d_s dd;
+
+	/* as a whole, lest the compiler reassembles it bit by bit */
+	memcpy(&dd, &d.d, sizeof(dd));
+	for (size_t i = 0U; i < nc;) {
+		if (!__dexcc_check(c + i, &d, dd)) {
+			/* on to the next conjunction */
+			i = c[i].nxt;
+		} else if (c[i].eoc) {
+			return true;
+		} else {
+			i++;
+		}
+	}
+	return false;
+}
+
+
+/* bounds, for chronologically sorted streams */
+static bool
+__dexkv_beyond_p(const_dexkv_t kv, struct dt_dt_s d, int dir)
+{
+/* whether D and everything past it in direction DIR (<0 earlier,
+ * >0 later) fails KV */
+	signed int cmp;
+
+	if (kv->sp.spfl != DT_SPFL_N_STD) {
+		/* fields don't bound anything */
+		return false;
+	} else if (dt_sandwich_only_t_p(kv->d)) {
+		/* neither do times of day */
+		return false;
+	} else if ((cmp = __cmp(d, kv->d)) == -2) {
+		return false;
+	}
+	switch (kv->op) {
+	case OP_UNK:
+	case OP_EQ:
+		return dir < 0 ? cmp < 0 : cmp > 0;
+	case OP_GT:
+		return dir < 0 && cmp <= 0;
+	case OP_GE:
+		return dir < 0 && cmp < 0;
+	case OP_LT:
+		return dir > 0 && cmp >= 0;
+	case OP_LE:
+		return dir > 0 && cmp > 0;
+	default:
+		break;
+	}
+	return false;
+}
+
+static bool
+__conj_beyond_p(const_dexpr_t dex, struct dt_dt_s d, int dir)
+{
+	const_dexpr_t a;
+
+	for (a = dex; a->type == DEX_CONJ; a = a->right) {
+		/* a&&b&&c comes as (a&&b)&&c */
+		if (a->left->type == DEX_CONJ) {
+			if (__conj_beyond_p(a->left, d, dir)) {
+				return true;
+			}
+		} else if (__dexkv_beyond_p(a->left->kv, d, dir)) {
+			return true;
+		}
+	}
+	/* rightmost cell might be a DEX_VAL */
+	return __dexkv_beyond_p(a->kv, d, dir);
+}
+
+static bool
+__disj_beyond_p(const_dexpr_t dex, struct dt_dt_s d, int dir)
+{
+	const_dexpr_t o;
+
+	for (o = dex; o->type == DEX_DISJ; o = o->right) {
+		/* normal forms may come as (a||b)||c */
+		if (o->left->type == DEX_DISJ) {
+			if (!__disj_beyond_p(o->left, d, dir)) {
+				return false;
+			}
+		} else if (!__conj_beyond_p(o->left, d, dir)) {
+			return false;
+		}
+	}
+	/* rightmost cell may be a DEX_VAL */
+	return __conj_beyond_p(o, d, dir);
+}
+
+static __attribute__((unused)) bool
+dexpr_beyond_p(const_dexpr_t dex, struct dt_dt_s d, int dir)
+{
+/* whether neither D nor anything before it (DIR < 0) or after it
+ * (DIR > 0) can match the simplified DEX */
+	return __disj_beyond_p(dex, d, dir);
+}
+
 
 #if defined STANDALONE
 const char *prog = "dexpr";
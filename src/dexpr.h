@@ -41,6 +41,42 @@ struct dexpr_s {
 	};
 };
 
+/* compiled dexprs, a flat list of checks, conjunctions one after another */
+enum {
+	/* walk the dexkv_s */
+	DEXCC_GEN,
+	/* date, time and date/time cells */
+	DEXCC_DU,
+	DEXCC_TU,
+	DEXCC_DTU,
+	/* dexkv_s that use the S slot */
+	DEXCC_YEAR,
+	DEXCC_MON,
+	DEXCC_MDAY,
+	DEXCC_WDAY,
+	DEXCC_WCNT_MON,
+	DEXCC_YDAY,
+	DEXCC_WCNT_YEAR,
+};
+
+struct dexcc_s {
+	/* key to compare, one of the above */
+	unsigned int key:4;
+	/* outcomes that pass, bit 0 for less, bit 1 for equal,
+	 * bit 2 for greater */
+	unsigned int msk:3;
+	/* last check of its conjunction */
+	unsigned int eoc:1;
+	/* type the stream must have for DU and DTU keys */
+	unsigned int typ:4;
+	/* index of the next conjunction, to go to upon failure */
+	uint32_t nxt;
+	signed int s;
+	uint32_t du;
+	uint64_t tu;
+	const_dexkv_t kv;
+};
+
 
 /* parser routine */
 extern int dexpr_parse(dexpr_t *root, const char *s, size_t l);
@@ -40,12 +40,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 #include <sys/time.h>
 #include <time.h>
 
 #include "dt-core.h"
 #include "dt-core-tz-glue.h"
 #include "dt-io.h"
+#include "dt-io-par.h"
 #include "dexpr.h"
 #include "dt-locale.h"
 #include "prchunk.h"
@@ -59,14 +61,18 @@ const char *prog = "dgrep";
 struct prln_ctx_s {
 	struct grep_atom_soa_s *ndl;
 	dexpr_t root;
+	const struct dexcc_s *cc;
+	size_t ncc;
 	zif_t fromz;
 	zif_t z;
 	unsigned int only_matching_p:1U;
 	unsigned int invert_match_p:1U;
+	/* only consider the first date/time on a line */
+	unsigned int first_only_p:1U;
 };
 
 static void
-proc_line(struct prln_ctx_s ctx, char *line, size_t llen)
+proc_line(struct prln_ctx_s ctx, dt_io_obuf_t ob, char *line, size_t llen)
 {
 	char *osp = NULL;
 	char *oep = NULL;
@@ -83,12 +89,17 @@ proc_line(struct prln_ctx_s ctx, char *line, size_t llen)
 		if (unkp) {
 			/* just plain nothing */
 			break;
+		} else if (ctx.first_only_p && osp != NULL) {
+			/* --sorted only goes by the first one */
+			break;
 		} else if (ctx.z != NULL) {
 			/* promote to zone ctx.z */
 			d = dtz_enrichz(d, ctx.z);
 		}
 		/* otherwise */
-		if (dexpr_matches_p(ctx.root, d)) {
+		if (LIKELY(ctx.cc != NULL)
+		    ? dexcc_matches_p(ctx.cc, ctx.ncc, d)
+		    : dexpr_matches_p(ctx.root, d)) {
 			if (ctx.invert_match_p) {
 				/* nothing must match */
 				return;
@@ -98,7 +109,7 @@ proc_line(struct prln_ctx_s ctx, char *line, size_t llen)
 			}
 			/* make sure we finish the line */
 			*ep++ = '\n';
-			__io_write(sp, ep - sp, stdout);
+			__io_bwrite(sp, ep - sp, ob);
 			return;
 		}
 	}
@@ -114,11 +125,73 @@ proc_line(struct prln_ctx_s ctx, char *line, size_t llen)
 		}
 		/* finish the line and bugger off */
 		*oep++ = '\n';
-		__io_write(osp, oep - osp, stdout);
+		__io_bwrite(osp, oep - osp, ob);
 	}
 	return;
 }
 
+static int
+proc_line_par(void *clo, dt_io_obuf_t ob, char *line, size_t llen)
+{
+	proc_line(*(const struct prln_ctx_s*)clo, ob, line, llen);
+	return 0;
+}
+
+static size_t
+sorted_bound(struct prln_ctx_s ctx, char *p, size_t n, int dir)
+{
+/* for lines in P (N bytes) whose first date/times are in chronological
+ * order return the offset of the first line that might match ROOT
+ * (DIR < 0) or of the first line after that that can't (DIR > 0),
+ * lines without date/times go either way */
+	size_t lo = 0U;
+	size_t hi = n;
+
+	while (lo < hi) {
+		char *mid = p + lo + (hi - lo) / 2U;
+		char *bol;
+		char *eol;
+		struct dt_dt_s d;
+
+		/* probe from the line after MID, or from LO */
+		if ((bol = memchr(mid, '\n', p + hi - mid)) == NULL ||
+		    ++bol >= p + hi) {
+			bol = p + lo;
+		}
+		for (mid = bol; bol < p + hi; bol = eol + 1U) {
+			char *sp, *ep;
+			char c;
+
+			if ((eol = memchr(bol, '\n', p + hi - bol)) == NULL) {
+				eol = p + hi;
+			}
+			/* the finder wants \0-terminated lines */
+			c = *eol;
+			*eol = '\0';
+			d = dt_io_find_strpdt2(
+				bol, eol - bol, ctx.ndl, &sp, &ep, ctx.fromz);
+			*eol = c;
+			if (!dt_unk_p(d)) {
+				break;
+			}
+		}
+		if (bol >= p + hi) {
+			/* no dates from MID on */
+			hi = mid - p;
+			continue;
+		} else if (ctx.z != NULL) {
+			d = dtz_enrichz(d, ctx.z);
+		}
+		if (dexpr_beyond_p(ctx.root, d, dir) == dir < 0) {
+			/* answer's past this line */
+			lo = eol + 1U - p;
+		} else {
+			hi = bol - p;
+		}
+	}
+	return lo < n ? lo : n;
+}
+
 
 #include "dgrep.yucc"
 
@@ -129,6 +202,8 @@ main(int argc, char *argv[])
 	char **fmt;
 	size_t nfmt;
 	dexpr_t root;
+	struct dexcc_s *cc;
+	size_t ncc = 0U;
 	oper_t o = OP_UNK;
 	int res = 0;
 
@@ -188,6 +263,8 @@ with complex expressions");
 
 	/* otherwise bring dexpr to normal form */
 	dexpr_simplify(root);
+	/* and compile it */
+	cc = dexpr_compile(root, &ncc);
 	/* beef */
 	{
 		/* read from stdin */
@@ -196,13 +273,18 @@ with complex expressions");
 		size_t nneedle = countof(__nstk);
 		struct grep_atom_soa_s ndlsoa;
 		void *pctx;
+		unsigned int njobs = dt_io_par_njobs(argi->jobs_arg);
+		dt_io_par_t par;
 		struct prln_ctx_s prln = {
 			.ndl = &ndlsoa,
 			.root = root,
+			.cc = cc,
+			.ncc = ncc,
 			.fromz = dt_io_zone(argi->from_zone_arg),
 			.z = dt_io_zone(argi->zone_arg),
 			.only_matching_p = argi->only_matching_flag,
 			.invert_match_p = argi->invert_match_flag,
+			.first_only_p = argi->sorted_flag,
 		};
 
 		/* no threads reading this stream */
@@ -222,13 +304,43 @@ with complex expressions");
 			serror("Error: could not open stdin");
 			goto ndl_free;
 		}
+		if (argi->sorted_flag && !argi->invert_match_flag) {
+			/* narrow mapped input down to the lines in question */
+			char *mem;
+			size_t len;
+
+			if ((mem = prchunk_mem(pctx, &len)) != NULL) {
+				size_t beg = sorted_bound(prln, mem, len, -1);
+				size_t end = beg + sorted_bound(
+					prln, mem + beg, len - beg, 1);
+
+				(void)prchunk_window(pctx, beg, end);
+			}
+		}
+		if (njobs > 1U && (par = dt_io_par_init(njobs)) != NULL) {
+			struct prln_ctx_s clo[njobs];
+			void *clop[njobs];
+
+			/* zones are shared, lookups cache per thread */
+			for (unsigned int i = 0U; i < njobs; i++) {
+				clo[i] = prln;
+				clop[i] = clo + i;
+			}
+			while (prchunk_fill(pctx) >= 0) {
+				(void)dt_io_par_proc(
+					par, pctx, proc_line_par, clop);
+			}
+			dt_io_par_free(par);
+			goto prch_free;
+		}
 		while (prchunk_fill(pctx) >= 0) {
 			for (char *line; prchunk_haslinep(pctx); lno++) {
 				size_t llen = prchunk_getline(pctx, &line);
 
-				proc_line(prln, line, llen);
+				proc_line(prln, NULL, line, llen);
 			}
 		}
+	prch_free:
 		/* get rid of resources */
 		free_prchunk(pctx);
 	ndl_free:
@@ -237,6 +349,7 @@ with complex expressions");
 		}
 	}
 	/* resource freeing */
+	free(cc);
 	free_dexpr(root);
 	dt_io_clear_zones();
 	if (argi->from_locale_arg) {
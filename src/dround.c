@@ -45,6 +45,7 @@
 
 #include "dt-core.h"
 #include "dt-io.h"
+#include "dt-io-par.h"
 #include "dt-core-tz-glue.h"
 #include "dt-locale.h"
 #include "prchunk.h"
@@ -760,7 +761,7 @@ struct prln_ctx_s {
 };
 
 static int
-proc_line(struct prln_ctx_s ctx, char *line, size_t llen)
+proc_line(struct prln_ctx_s ctx, dt_io_obuf_t ob, char *line, size_t llen)
 {
 	struct dt_dt_s d;
 	char *sp = NULL;
@@ -785,17 +786,17 @@ proc_line(struct prln_ctx_s ctx, char *line, size_t llen)
 			}
 
 			if (ctx.sed_mode_p) {
-				__io_write(line, sp - line, stdout);
-				dt_io_write(d, ctx.ofmt, ctx.outz, '\0');
+				__io_bwrite(line, sp - line, ob);
+				dt_io_bwrite(d, ctx.ofmt, ctx.outz, '\0', ob);
 				llen -= (ep - line);
 				line = ep;
 			} else {
-				dt_io_write(d, ctx.ofmt, ctx.outz, '\n');
+				dt_io_bwrite(d, ctx.ofmt, ctx.outz, '\n', ob);
 				break;
 			}
 		} else if (ctx.sed_mode_p) {
 			line[llen] = '\n';
-			__io_write(line, llen + 1, stdout);
+			__io_bwrite(line, llen + 1, ob);
 			break;
 		} else {
 			/* obviously unmatched, warn about it in non -q mode */
@@ -809,6 +810,12 @@ proc_line(struct prln_ctx_s ctx, char *line, size_t llen)
 	return rc;
 }
 
+static int
+proc_line_par(void *clo, dt_io_obuf_t ob, char *line, size_t llen)
+{
+	return proc_line(*(const struct prln_ctx_s*)clo, ob, line, llen);
+}
+
 
 #include "dround.yucc"
 
@@ -1073,9 +1080,11 @@ no durations given");
 				dt_io_write(d, ofmt, z, '\n');
 				continue;
 			empty:
-				__io_write("\n", 1U, stdout);
+				dt_io_owrite("\n", 1U);
 			}
 		}
+		/* get rid of resources */
+		free_prchunk(pctx);
 	} else {
 		/* read from stdin */
 		size_t lno = 0;
@@ -1083,6 +1092,8 @@ no durations given");
 		size_t nneedle = countof(__nstk);
 		struct grep_atom_soa_s ndlsoa;
 		void *pctx;
+		unsigned int njobs = dt_io_par_njobs(argi->jobs_arg);
+		dt_io_par_t par;
 		struct prln_ctx_s prln = {
 			.ndl = &ndlsoa,
 			.ofmt = ofmt,
@@ -1112,13 +1123,30 @@ no durations given");
 			serror("Error: could not open stdin");
 			goto ndl_free;
 		}
+		if (njobs > 1U && (par = dt_io_par_init(njobs)) != NULL) {
+			struct prln_ctx_s clo[njobs];
+			void *clop[njobs];
+
+			/* zones are shared, lookups cache per thread */
+			for (unsigned int i = 0U; i < njobs; i++) {
+				clo[i] = prln;
+				clop[i] = clo + i;
+			}
+			while (prchunk_fill(pctx) >= 0) {
+				rc |= dt_io_par_proc(
+					par, pctx, proc_line_par, clop);
+			}
+			dt_io_par_free(par);
+			goto prch_free;
+		}
 		while (prchunk_fill(pctx) >= 0) {
 			for (char *line; prchunk_haslinep(pctx); lno++) {
 				size_t llen = prchunk_getline(pctx, &line);
 
-				rc |= proc_line(prln, line, llen);
+				rc |= proc_line(prln, NULL, line, llen);
 			}
 		}
+	prch_free:
 		/* get rid of resources */
 		free_prchunk(pctx);
 	ndl_free:
@@ -41,86 +41,629 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
-#include <sys/time.h>
-#include <sys/wait.h>
+#include <string.h>
+#include <stdbool.h>
 #include <fcntl.h>
 #include <time.h>
+#if defined HAVE_PTHREAD_H
+# include <pthread.h>
+#endif	/* HAVE_PTHREAD_H */
 
 #include "dt-core.h"
 #include "dt-io.h"
+#include "dt-io-par.h"
 #include "dt-locale.h"
 #include "prchunk.h"
 
 const char *prog = "dsort";
 
-struct prln_ctx_s {
-	struct grep_atom_soa_s *ndl;
-	zif_t fromz;
-	int outfd;
+/* one line of the current batch, KEY is the binary sort key,
+ * the line itself lives in the arena at OFF, LEN includes the newline */
+struct dsrec_s {
+	uint64_t key;
+	size_t off;
+	size_t len;
 };
 
-struct sort_ctx_s {
+#define DSORT_MAXRUNS	(64U)
+/* spilled runs a sorter keeps open, more get merged into one first */
+#define DSORT_MAXMERGE	(64U)
+
+struct dsort_s {
+	/* line arena and records of the current batch */
+	char *arena;
+	size_t arz;
+	size_t ari;
+	struct dsrec_s *rec;
+	size_t recz;
+	size_t nrec;
+	/* starts of the monotone runs in the current batch,
+	 * beyond DSORT_MAXRUNS runs only their number is kept */
+	size_t roff[DSORT_MAXRUNS];
+	size_t nroff;
+	/* bytes a batch may take up before it is spilled */
+	size_t budget;
+	/* sorted runs spilled to temporary files */
+	FILE **runs;
+	size_t nruns;
+
 	unsigned int revp:1U;
 	unsigned int unqp:1U;
+	/* for -u, whether LAST holds the last key written */
+	unsigned int lastp:1U;
+	uint64_t last;
+};
+
+struct prln_ctx_s {
+	struct grep_atom_soa_s *ndl;
+	zif_t fromz;
+	struct dsort_s *s;
 };
 
-
+#define DSORT_BUDGET	(256U * 1024U * 1024U)
+
+
+/* keys */
+static uint64_t
+dsort_key(struct dt_dt_s d)
+{
+/* map D to a 64bit key whose unsigned order is the order of dsort,
+ * lines without dates come first, then times without dates, then
+ * dates and date/times as microseconds since the epoch, the lowest
+ * bit puts a date before all date/times on the same day */
+	int64_t k;
+
+	if (dt_unk_p(d)) {
+		k = INT64_MIN;
+	} else if (dt_sandwich_only_t_p(d)) {
+		int64_t us = (d.t.hms.h * 60 + d.t.hms.m) * 60 + d.t.hms.s;
+
+		us = us * 1000000 + d.t.hms.ns / 1000U;
+		k = INT64_MIN + 1 + us * 2;
+	} else {
+		int64_t us = dt_to_unix_epoch(d) * 1000000;
+
+		if (d.typ == DT_SEXY) {
+			k = us * 2 + 1;
+		} else if (dt_sandwich_p(d)) {
+			k = (us + d.t.hms.ns / 1000U) * 2 + 1;
+		} else {
+			k = us * 2;
+		}
+	}
+	/* flip the sign bit so that keys compare as unsigned */
+	return (uint64_t)k ^ 0x8000000000000000ULL;
+}
+
 static void
-safe_write(int fd, const char *buf, size_t bsz)
+dsort_radix(struct dsrec_s *restrict r, struct dsrec_s *restrict tmp, size_t n)
 {
-	size_t tot = 0U;
-	for (ssize_t nwr;
-	     tot < bsz && (nwr = write(fd, buf + tot, bsz - tot)) >= 0;
-	     tot += nwr);
+/* stable LSD radix sort of R by key, byte by byte, TMP holds N records */
+	size_t cnt[8U][256U] = {0U};
+	struct dsrec_s *src = r, *dst = tmp;
+
+	for (size_t i = 0U; i < n; i++) {
+		for (unsigned int b = 0U; b < 8U; b++) {
+			cnt[b][(r[i].key >> (b * 8U)) & 0xffU]++;
+		}
+	}
+	for (unsigned int b = 0U; b < 8U; b++) {
+		const unsigned int sh = b * 8U;
+
+		if (cnt[b][(r[0U].key >> sh) & 0xffU] == n) {
+			/* all keys share this byte */
+			continue;
+		}
+		for (size_t i = 0U, sum = 0U; i < 256U; i++) {
+			size_t c = cnt[b][i];
+			cnt[b][i] = sum;
+			sum += c;
+		}
+		for (size_t i = 0U; i < n; i++) {
+			dst[cnt[b][(src[i].key >> sh) & 0xffU]++] = src[i];
+		}
+		with (struct dsrec_s *x = src) {
+			src = dst;
+			dst = x;
+		}
+	}
+	if (src != r) {
+		memcpy(r, src, n * sizeof(*r));
+	}
 	return;
 }
 
+static inline bool
+dsort_mrg_lt(const struct dsrec_s *r, const size_t *cur, size_t i, size_t j)
+{
+/* earlier runs hold earlier input, ties go to them to keep it stable */
+	return r[cur[i]].key < r[cur[j]].key ||
+		(r[cur[i]].key == r[cur[j]].key && i < j);
+}
+
 static void
-proc_line(struct prln_ctx_s ctx, char *line, size_t llen)
+dsort_mrg_sift(
+	const struct dsrec_s *r, const size_t *cur, size_t *h, size_t nh, size_t i)
 {
-	struct dt_dt_s d;
+	for (size_t c; (c = 2U * i + 1U) < nh; i = c) {
+		if (c + 1U < nh && dsort_mrg_lt(r, cur, h[c + 1U], h[c])) {
+			c++;
+		}
+		if (!dsort_mrg_lt(r, cur, h[c], h[i])) {
+			break;
+		}
+		with (size_t x = h[c]) {
+			h[c] = h[i];
+			h[i] = x;
+		}
+	}
+	return;
+}
 
-	do {
-		char buf[64U];
-		char *sp, *tp;
-		char *bp = buf;
-		const char *const ep = buf + sizeof(buf);
-
-		/* find first occurrence then */
-		d = dt_io_find_strpdt2(
-			line, llen, ctx.ndl, &sp, &tp, ctx.fromz);
-		/* print line, first thing */
-		safe_write(ctx.outfd, line, llen);
-
-		/* extend by separator */
-		*bp++ = '\001';
-		/* check if line matches */
-		if (!dt_unk_p(d)) {
-			/* match! */
-			if (!dt_sandwich_only_t_p(d)) {
-				bp += dt_strfdt(bp, ep - bp, "%F", d);
-			}
-			*bp++ = '\001';
-			if (!dt_sandwich_only_d_p(d)) {
-				bp += dt_strfdt(bp, ep - bp, "%T", d);
-			}
-		} else {
-			/* just two empty fields then, innit? */
-			*bp++ = '\001';
+static void
+dsort_mrg(
+	const struct dsrec_s *restrict r, struct dsrec_s *restrict tmp,
+	size_t n, const size_t *roff, size_t nr)
+{
+/* merge the NR monotone runs of R that start at ROFF into TMP */
+	size_t cur[DSORT_MAXRUNS], end[DSORT_MAXRUNS];
+	size_t h[DSORT_MAXRUNS], nh = nr;
+
+	for (size_t i = 0U; i < nr; i++) {
+		cur[i] = roff[i];
+		end[i] = i + 1U < nr ? roff[i + 1U] : n;
+		h[i] = i;
+	}
+	for (size_t i = nh / 2U; i-- > 0U;) {
+		dsort_mrg_sift(r, cur, h, nh, i);
+	}
+	for (size_t o = 0U; nh; o++) {
+		const size_t top = h[0U];
+
+		tmp[o] = r[cur[top]++];
+		if (cur[top] >= end[top]) {
+			h[0U] = h[--nh];
+		}
+		dsort_mrg_sift(r, cur, h, nh, 0U);
+	}
+	return;
+}
+
+
+/* the sorter */
+static void
+free_dsort(struct dsort_s *s)
+{
+	for (size_t i = 0U; i < s->nruns; i++) {
+		fclose(s->runs[i]);
+	}
+	free(s->runs);
+	free(s->arena);
+	free(s->rec);
+	return;
+}
+
+static size_t
+dsort_batchsz(const struct dsort_s *s, size_t llen)
+{
+/* bytes the current batch takes up with another line of LLEN,
+ * records count twice because of the radix sort's scratch space */
+	return s->ari + llen + (s->nrec + 1U) * 2U * sizeof(*s->rec);
+}
+
+static int
+dsort_sort(struct dsort_s *s)
+{
+	struct dsrec_s *tmp;
+
+	if (s->nroff <= 1U) {
+		/* presorted */
+		return 0;
+	} else if ((tmp = malloc(s->nrec * sizeof(*tmp))) == NULL) {
+		serror("Error: cannot allocate sort buffer");
+		return -1;
+	}
+	if (s->nroff <= DSORT_MAXRUNS) {
+		/* few runs, merge them */
+		dsort_mrg(s->rec, tmp, s->nrec, s->roff, s->nroff);
+		memcpy(s->rec, tmp, s->nrec * sizeof(*tmp));
+	} else {
+		dsort_radix(s->rec, tmp, s->nrec);
+	}
+	s->nroff = 1U;
+	free(tmp);
+	return 0;
+}
+
+static void
+dsort_put(FILE *f, uint64_t key, const char *ln, size_t len)
+{
+	fwrite(&key, sizeof(key), 1U, f);
+	fwrite(&len, sizeof(len), 1U, f);
+	fwrite(ln, 1U, len, f);
+	return;
+}
+
+static int
+dsort_seal(FILE *f)
+{
+/* finish writing the run in F and get it ready for reading,
+ * F is closed if that fails */
+	if (fflush(f) < 0 || ferror(f)) {
+		serror("Error: cannot write temporary file");
+		fclose(f);
+		return -1;
+	}
+	rewind(f);
+	return 0;
+}
+
+static FILE*
+dsort_tmpfile(void)
+{
+	const char *tmpd = getenv("TMPDIR") ?: "/tmp";
+	char fn[4096U];
+	FILE *res;
+	int fd;
+
+	snprintf(fn, sizeof(fn), "%s/dsort.XXXXXX", tmpd);
+	if ((fd = mkstemp(fn)) < 0) {
+		serror("Error: cannot create temporary file in `%s'", tmpd);
+		return NULL;
+	}
+	/* nobody needs to see it */
+	unlink(fn);
+	if ((res = fdopen(fd, "w+")) == NULL) {
+		close(fd);
+		return NULL;
+	}
+	setvbuf(res, NULL, _IOFBF, 65536U);
+	return res;
+}
+
+static inline void
+dsort_emit(struct dsort_s *s, uint64_t key, const char *ln, size_t len)
+{
+	if (s->unqp) {
+		if (s->lastp && key == s->last) {
+			return;
+		}
+		s->last = key;
+		s->lastp = 1U;
+	}
+	dt_io_owrite(ln, len);
+	return;
+}
+
+
+/* merging */
+struct dsrun_s {
+	uint64_t key;
+	const char *ln;
+	size_t len;
+	/* either a spilled run */
+	FILE *f;
+	char *buf;
+	size_t bsz;
+	/* or the batch still in memory */
+	const struct dsrec_s *r, *er;
+	const char *arena;
+};
+
+static int
+dsrun_next(struct dsrun_s *r)
+{
+/* advance R to its next line, return 0 if there was one */
+	if (r->f == NULL) {
+		if (r->r >= r->er) {
+			return -1;
 		}
-		/* finalise the line and print */
-		*bp++ = '\n';
-		safe_write(ctx.outfd, buf, bp - buf);
-	} while (0);
+		r->key = r->r->key;
+		r->ln = r->arena + r->r->off;
+		r->len = r->r->len;
+		r->r++;
+		return 0;
+	}
+	if (fread(&r->key, sizeof(r->key), 1U, r->f) < 1U ||
+	    fread(&r->len, sizeof(r->len), 1U, r->f) < 1U) {
+		return -1;
+	}
+	if (UNLIKELY(r->len > r->bsz)) {
+		size_t nu = r->len < 256U ? 256U : r->len * 2U;
+		char *nb = realloc(r->buf, nu);
+
+		if (nb == NULL) {
+			return -1;
+		}
+		r->buf = nb;
+		r->bsz = nu;
+	}
+	if (fread(r->buf, 1U, r->len, r->f) < r->len) {
+		return -1;
+	}
+	r->ln = r->buf;
+	return 0;
+}
+
+static inline bool
+dsrun_lt(const struct dsrun_s *rs, size_t i, size_t j)
+{
+/* earlier runs hold earlier input, ties go to them to keep it stable */
+	return rs[i].key < rs[j].key || (rs[i].key == rs[j].key && i < j);
+}
+
+static void
+dsrun_sift(const struct dsrun_s *rs, size_t *h, size_t nh, size_t i)
+{
+	for (size_t c; (c = 2U * i + 1U) < nh; i = c) {
+		if (c + 1U < nh && dsrun_lt(rs, h[c + 1U], h[c])) {
+			c++;
+		}
+		if (!dsrun_lt(rs, h[c], h[i])) {
+			break;
+		}
+		with (size_t x = h[c]) {
+			h[c] = h[i];
+			h[i] = x;
+		}
+	}
 	return;
 }
 
+static int
+dsort_heap(struct dsort_s *s, struct dsrun_s *rs, size_t nrs, FILE *out)
+{
+/* merge the NRS runs in RS, into the run OUT or, if NULL, to stdout
+ * by way of S's dsort_emit(), frees the runs' buffers */
+	size_t *h, nh = 0U;
+	int rc = 0;
+
+	if ((h = calloc(nrs, sizeof(*h))) == NULL) {
+		serror("Error: cannot allocate merge buffers");
+		return -1;
+	}
+	for (size_t i = 0U; i < nrs; i++) {
+		if (dsrun_next(rs + i) == 0) {
+			h[nh++] = i;
+		}
+	}
+	for (size_t i = nh / 2U; i-- > 0U;) {
+		dsrun_sift(rs, h, nh, i);
+	}
+	while (nh) {
+		struct dsrun_s *r = rs + h[0U];
+
+		if (out != NULL) {
+			dsort_put(out, r->key, r->ln, r->len);
+		} else {
+			dsort_emit(s, r->key, r->ln, r->len);
+		}
+		if (dsrun_next(r) < 0) {
+			if (r->f != NULL && ferror(r->f)) {
+				serror("Error: cannot read temporary file");
+				rc = -1;
+			}
+			h[0U] = h[--nh];
+		}
+		dsrun_sift(rs, h, nh, 0U);
+	}
+	for (size_t i = 0U; i < nrs; i++) {
+		free(rs[i].buf);
+	}
+	free(h);
+	return rc;
+}
+
+static int
+dsort_compact(struct dsort_s *s)
+{
+/* merge the runs S has spilled into one, keeping it in their place */
+	struct dsrun_s *rs;
+	FILE *f;
+
+	if (s->nruns <= 1U) {
+		return 0;
+	} else if ((rs = calloc(s->nruns, sizeof(*rs))) == NULL) {
+		serror("Error: cannot allocate merge buffers");
+		return -1;
+	} else if ((f = dsort_tmpfile()) == NULL) {
+		free(rs);
+		return -1;
+	}
+	for (size_t i = 0U; i < s->nruns; i++) {
+		rs[i].f = s->runs[i];
+	}
+	if (dsort_heap(s, rs, s->nruns, f) < 0) {
+		free(rs);
+		fclose(f);
+		return -1;
+	}
+	free(rs);
+	if (dsort_seal(f) < 0) {
+		return -1;
+	}
+	for (size_t i = 0U; i < s->nruns; i++) {
+		fclose(s->runs[i]);
+	}
+	/* it holds the earliest input, so it goes first */
+	s->runs[0U] = f;
+	s->nruns = 1U;
+	return 0;
+}
+
+static int
+dsort_merge(struct dsort_s *s, size_t ns)
+{
+/* k-way merge of the spilled runs and the batches in memory of
+ * the NS sorters in S, in input order */
+	size_t nrs = 0U;
+	struct dsrun_s *rs;
+	int rc;
+
+	for (size_t k = 0U; k < ns; k++) {
+		nrs += s[k].nruns + 1U;
+	}
+
+	if ((rs = calloc(nrs, sizeof(*rs))) == NULL) {
+		serror("Error: cannot allocate merge buffers");
+		return -1;
+	}
+	for (size_t k = 0U, j = 0U; k < ns; k++, j++) {
+		for (size_t i = 0U; i < s[k].nruns; i++, j++) {
+			rs[j].f = s[k].runs[i];
+		}
+		rs[j].r = s[k].rec;
+		rs[j].er = s[k].rec + s[k].nrec;
+		rs[j].arena = s[k].arena;
+	}
+
+	rc = dsort_heap(s, rs, nrs, NULL);
+	free(rs);
+	return rc;
+}
+
+static int
+dsort_spill(struct dsort_s *s)
+{
+/* sort the current batch and write it out as a run */
+	FILE *f;
+
+	if (dsort_sort(s) < 0) {
+		return -1;
+	} else if ((f = dsort_tmpfile()) == NULL) {
+		return -1;
+	}
+	for (size_t i = 0U; i < s->nrec; i++) {
+		const struct dsrec_s r = s->rec[i];
+		dsort_put(f, r.key, s->arena + r.off, r.len);
+	}
+	if (dsort_seal(f) < 0) {
+		return -1;
+	}
+	if (!(s->nruns % 16U)) {
+		size_t nu = s->nruns + 16U;
+		FILE **nr = realloc(s->runs, nu * sizeof(*s->runs));
+
+		if (nr == NULL) {
+			fclose(f);
+			return -1;
+		}
+		s->runs = nr;
+	}
+	s->runs[s->nruns++] = f;
+	/* start afresh */
+	s->ari = 0U;
+	s->nrec = 0U;
+	s->nroff = 0U;
+	if (s->nruns >= DSORT_MAXMERGE) {
+		/* don't run out of descriptors */
+		return dsort_compact(s);
+	}
+	return 0;
+}
+
+static int
+dsort_add(struct dsort_s *s, uint64_t key, const char *line, size_t llen)
+{
+	if (s->nrec && dsort_batchsz(s, llen + 1U) > s->budget) {
+		if (dsort_spill(s) < 0) {
+			return -1;
+		}
+	}
+	if (UNLIKELY(s->ari + llen + 1U > s->arz)) {
+		size_t nu = (s->arz ?: 65536U);
+		char *na;
+
+		while (nu < s->ari + llen + 1U) {
+			nu *= 2U;
+		}
+		if ((na = realloc(s->arena, nu)) == NULL) {
+			serror("Error: cannot allocate line buffer");
+			return -1;
+		}
+		s->arena = na;
+		s->arz = nu;
+	}
+	if (UNLIKELY(s->nrec >= s->recz)) {
+		size_t nu = (s->recz ?: 4096U) * 2U;
+		struct dsrec_s *nr = realloc(s->rec, nu * sizeof(*s->rec));
+
+		if (nr == NULL) {
+			serror("Error: cannot allocate line buffer");
+			return -1;
+		}
+		s->rec = nr;
+		s->recz = nu;
+	}
+	if (!s->nrec || key < s->rec[s->nrec - 1U].key) {
+		/* a new run begins */
+		if (s->nroff < DSORT_MAXRUNS) {
+			s->roff[s->nroff] = s->nrec;
+		}
+		s->nroff++;
+	}
+	memcpy(s->arena + s->ari, line, llen);
+	s->arena[s->ari + llen] = '\n';
+	s->rec[s->nrec++] = (struct dsrec_s){key, s->ari, llen + 1U};
+	s->ari += llen + 1U;
+	return 0;
+}
+
+static int
+dsort_finish(struct dsort_s *s, size_t ns)
+{
+/* write out the lines of the NS sorters in S, -u is tracked in S[0] */
+	size_t nruns = 0U;
+
+	for (size_t k = 0U; k < ns; k++) {
+		if (dsort_sort(s + k) < 0) {
+			return -1;
+		}
+		nruns += s[k].nruns;
+	}
+	for (size_t k = 0U; nruns > DSORT_MAXMERGE && k < ns; k++) {
+		/* too many runs for one merge, one per file must do */
+		nruns -= s[k].nruns;
+		if (dsort_compact(s + k) < 0) {
+			return -1;
+		}
+		nruns += s[k].nruns;
+	}
+	if (ns > 1U || s->nruns) {
+		return dsort_merge(s, ns);
+	}
+	for (size_t i = 0U; i < s->nrec; i++) {
+		const struct dsrec_s r = s->rec[i];
+		dsort_emit(s, r.key, s->arena + r.off, r.len);
+	}
+	return 0;
+}
+
+
+static int
+proc_line(struct prln_ctx_s ctx, char *line, size_t llen)
+{
+	struct dt_dt_s d;
+	char *sp, *tp;
+	uint64_t key;
+
+	/* find first occurrence then */
+	d = dt_io_find_strpdt2(line, llen, ctx.ndl, &sp, &tp, ctx.fromz);
+	key = dsort_key(d);
+	if (ctx.s->revp) {
+		/* stays stable for equal keys */
+		key = ~key;
+	}
+	return dsort_add(ctx.s, key, line, llen);
+}
+
 static int
 proc_file(struct prln_ctx_s prln, const char *fn)
 {
 	size_t lno = 0;
 	void *pctx;
 	int fd;
+	int rc = 0;
 
 	if (fn == NULL) {
 		/* stdin then innit */
@@ -140,105 +683,121 @@ proc_file(struct prln_ctx_s prln, const char *fn)
 		for (char *line; prchunk_haslinep(pctx); lno++) {
 			size_t llen = prchunk_getline(pctx, &line);
 
-			proc_line(prln, line, llen);
+			if (UNLIKELY(proc_line(prln, line, llen) < 0)) {
+				rc = -1;
+				goto out;
+			}
 		}
 	}
+out:
 	/* get rid of resources */
 	free_prchunk(pctx);
 	close(fd);
-	return 0;
+	return rc;
 }
 
-
-/* helper children, sort(1) and cut(1) */
-static pid_t
-spawn_sort(int *restrict infd, const int outfd, struct sort_ctx_s sopt)
-{
-	static char *cmdline[16U] = {"sort", "-t", "-k2"};
-	pid_t sortp;
-	/* to snarf off traffic from the child */
-	int intfd[2];
-
-	if (pipe(intfd) < 0) {
-		serror("pipe setup to/from sort failed");
-		return -1;
-	}
-
-	switch ((sortp = vfork())) {
-	case -1:
-		/* i am an error */
-		serror("vfork for sort failed");
-		return -1;
+/* every input file gets a sorter of its own, the workers take them
+ * in turns and sort what's left in memory before the final merge */
+struct dsjob_s {
+	struct prln_ctx_s prln;
+	char *const *fn;
+	struct dsort_s *s;
+	size_t ns;
+	size_t *next;
+	int rc;
+};
 
-	default:
-		/* i am the parent */
-		close(intfd[0]);
-		*infd = intfd[1];
-		/* close outfd here already */
-		close(outfd);
-		return sortp;
+static void*
+dsort_work(void *clo)
+{
+	struct dsjob_s *j = clo;
 
-	case 0:;
-		char **cp = cmdline + 3U;
+	for (size_t i;
+	     (i = __atomic_fetch_add(j->next, 1U, __ATOMIC_RELAXED)) < j->ns;) {
+		struct prln_ctx_s prln = j->prln;
 
-		/* i am the child */
-		if (sopt.revp) {
-			*cp++ = "-r";
+		prln.s = j->s + i;
+		if (proc_file(prln, j->fn ? j->fn[i] : NULL) < 0) {
+			j->rc = 1;
 		}
-		if (sopt.unqp) {
-			*cp++ = "-u";
+		if (dsort_sort(prln.s) < 0) {
+			j->rc = 1;
 		}
-		*cp++ = NULL;
-
-		/* stdout -> outfd */
-		dup2(outfd, STDOUT_FILENO);
-		/* *infd -> stdin */
-		dup2(intfd[0], STDIN_FILENO);
-		close(intfd[1]);
-
-		execvp("sort", cmdline);
-		serror("execvp(sort) failed");
-		_exit(EXIT_FAILURE);
 	}
+	return NULL;
 }
 
-static pid_t
-spawn_cut(int *restrict infd)
+static int
+proc_files(
+	struct prln_ctx_s prln, char *const *fn, struct dsort_s *s, size_t ns,
+	unsigned int njobs)
 {
-	static char *const cmdline[] = {"cut", "-d", "-f1", NULL};
-	pid_t cutp;
-	/* to snarf off traffic from the child */
-	int intfd[2];
+/* read the NS files FN (or stdin if FN is NULL) into S using NJOBS threads */
+	const unsigned int nth = njobs < ns ? njobs : (unsigned int)ns;
+	struct dsjob_s j[nth];
+	size_t next = 0U;
+	int rc = 0;
 
-	if (pipe(intfd) < 0) {
-		serror("pipe setup to/from cut failed");
-		return -1;
+	for (unsigned int k = 0U; k < nth; k++) {
+		j[k] = (struct dsjob_s){prln, fn, s, ns, &next, 0};
 	}
+#if defined HAVE_PTHREAD_H
+	{
+		pthread_t th[nth];
+		unsigned int k;
 
-	switch ((cutp = vfork())) {
-	case -1:
-		/* i am an error */
-		serror("vfork for cut failed");
-		return -1;
-
-	default:;
-		/* i am the parent */
-		close(intfd[0]);
-		*infd = intfd[1];
-		return cutp;
-
-	case 0:;
-		/* i am the child */
-		dup2(intfd[0], STDIN_FILENO);
-		close(intfd[1]);
+		if (nth > 1U) {
+			/* don't let the workers race for the globals */
+			dt_io_par_prep();
+		}
+		for (k = 1U; k < nth; k++) {
+			if (pthread_create(th + k, NULL, dsort_work, j + k)) {
+				break;
+			}
+		}
+		/* we work as well */
+		(void)dsort_work(j);
+		while (--k > 0U) {
+			pthread_join(th[k], NULL);
+		}
+	}
+#else  /* !HAVE_PTHREAD_H */
+	(void)dsort_work(j);
+#endif	/* HAVE_PTHREAD_H */
+	for (unsigned int k = 0U; k < nth; k++) {
+		rc |= j[k].rc;
+	}
+	return rc;
+}
 
-		execvp("cut", cmdline);
-		serror("execvp(cut) failed");
-		_exit(EXIT_FAILURE);
+static size_t
+strtosz(const char *str)
+{
+/* read a size with an optional k, M or G suffix, 0 on error */
+	char *on;
+	size_t res = strtoul(str, &on, 10);
+
+	switch (*on) {
+	case 'k':
+	case 'K':
+		res <<= 10U;
+		on++;
+		break;
+	case 'M':
+		res <<= 20U;
+		on++;
+		break;
+	case 'G':
+		res <<= 30U;
+		on++;
+		break;
+	default:
+		break;
 	}
+	return *on ? 0U : res;
 }
 
-
+
 #include "dsort.yucc"
 
 int
@@ -249,7 +808,7 @@ main(int argc, char *argv[])
 	size_t nfmt;
 	zif_t fromz = NULL;
 	int rc = 0;
-	struct sort_ctx_s sopt = {0U};
+	struct dsort_s proto = {.budget = DSORT_BUDGET};
 
 	if (yuck_parse(argi, argc, argv)) {
 		rc = 1;
@@ -276,12 +835,18 @@ main(int argc, char *argv[])
 		dt_set_base(base);
 	}
 
-	/* prepare a mini-argi for the sort invocation */
 	if (argi->reverse_flag) {
-		sopt.revp = 1U;
+		proto.revp = 1U;
 	}
 	if (argi->unique_flag) {
-		sopt.unqp = 1U;
+		proto.unqp = 1U;
+	}
+	if (argi->buffer_size_arg &&
+	    !(proto.budget = strtosz(argi->buffer_size_arg))) {
+		error("Error: invalid buffer size `%s'",
+		      argi->buffer_size_arg);
+		rc = 1;
+		goto out;
 	}
 
 	{
@@ -293,7 +858,10 @@ main(int argc, char *argv[])
 			.ndl = &ndlsoa,
 			.fromz = fromz,
 		};
-		pid_t cutp, sortp;
+		/* stdin counts as one file */
+		const size_t ns = argi->nargs ?: 1U;
+		struct dsort_s *sorter;
+		unsigned int njobs = dt_io_par_njobs(argi->jobs_arg);
 
 		/* lest we overflow the stack */
 		if (nfmt >= nneedle) {
@@ -304,42 +872,30 @@ main(int argc, char *argv[])
 		/* and now build the needles */
 		ndlsoa = build_needle(needle, nneedle, fmt, nfmt);
 
-		/* spawn children */
-		with (int ifd, ofd) {
-			if ((cutp = spawn_cut(&ifd)) < 0) {
-				goto ndl_free;
-			}
-			if ((sortp = spawn_sort(&ofd, ifd, sopt)) < 0) {
-				goto ndl_free;
-			}
-			prln.outfd = ofd;
+		if ((sorter = calloc(ns, sizeof(*sorter))) == NULL) {
+			serror("Error: cannot allocate sorters");
+			rc = 1;
+			goto ndl_free;
 		}
-
-		for (size_t i = 0U; i < argi->nargs || i == 0U; i++) {
-			if (proc_file(prln, argi->args[i]) < 0) {
-				rc = 1;
-			}
+		/* the memory budget is shared among all files */
+		proto.budget = proto.budget / ns ?: 1U;
+		for (size_t i = 0U; i < ns; i++) {
+			sorter[i] = proto;
 		}
-
-		/* indicate we're no longer writing to the sort helper */
-		close(prln.outfd);
-
-		/* wait for sort first */
-		with (int st) {
-			while (waitpid(sortp, &st, 0) != sortp);
-			if (WIFEXITED(st) && WEXITSTATUS(st)) {
-				rc = rc ?: WEXITSTATUS(st);
-			}
+		if (proc_files(prln, argi->nargs ? argi->args : NULL,
+			       sorter, ns, njobs)) {
+			/* a partial sort is no sort */
+			rc = 1;
+		} else if (dsort_finish(sorter, ns) < 0) {
+			rc = 1;
 		}
-		/* wait for cut then */
-		with (int st) {
-			while (waitpid(cutp, &st, 0) != cutp);
-			if (WIFEXITED(st) && WEXITSTATUS(st)) {
-				rc = rc ?: WEXITSTATUS(st);
-			}
+		for (size_t i = 0U; i < ns; i++) {
+			free_dsort(sorter + i);
 		}
+		free(sorter);
 
 	ndl_free:
+
 		if (needle != __nstk) {
 			free(needle);
 		}
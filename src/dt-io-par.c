@@ -0,0 +1,260 @@
+/*** dt-io-par.c -- multi-threaded line processing
+ *
+ * Copyright (C) 2020 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of dateutils.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#if defined HAVE_PTHREAD_H
+# include <pthread.h>
+#endif	/* HAVE_PTHREAD_H */
+#include "dt-core.h"
+#include "dt-locale.h"
+#include "dt-io.h"
+#include "dt-io-par.h"
+#include "prchunk.h"
+#include "nifty.h"
+
+/* minimum number of lines per job, so we don't start threads for
+ * a handful of lines */
+#define MIN_LINES_PER_JOB	(256U)
+
+struct line_s {
+	char *line;
+	size_t llen;
+};
+
+struct job_s {
+	dt_io_par_f fn;
+	void *clo;
+	const struct line_s *beg;
+	const struct line_s *end;
+	struct dt_io_obuf_s ob;
+	int rc;
+};
+
+struct dt_io_par_s {
+	unsigned int njobs;
+	/* lines of the current chunk */
+	size_t nlines;
+	size_t zlines;
+	struct line_s *lines;
+	/* job descriptors */
+	struct job_s jobs[];
+};
+
+
+static void*
+__work(void *arg)
+{
+	struct job_s *j = arg;
+	int rc = 0;
+
+	for (const struct line_s *l = j->beg; l < j->end; l++) {
+		rc |= j->fn(j->clo, &j->ob, l->line, l->llen);
+	}
+	j->rc = rc;
+	return NULL;
+}
+
+static int
+__snarf_lines(struct dt_io_par_s *par, prch_ctx_t pctx)
+{
+/* collect the lines of the current chunk, this uses the very same
+ * iteration as the serial line processors */
+	par->nlines = 0U;
+	for (char *line; prchunk_haslinep(pctx); par->nlines++) {
+		size_t llen = prchunk_getline(pctx, &line);
+
+		if (UNLIKELY(par->nlines >= par->zlines)) {
+			size_t nu = (par->zlines * 2U) ?: 16384U;
+			void *tmp;
+
+			tmp = realloc(par->lines, nu * sizeof(*par->lines));
+			if (UNLIKELY(tmp == NULL)) {
+				return -1;
+			}
+			par->lines = tmp;
+			par->zlines = nu;
+		}
+		par->lines[par->nlines] = (struct line_s){line, llen};
+	}
+	return 0;
+}
+
+
+/* public API */
+unsigned int
+dt_io_par_njobs(const char *arg)
+{
+	long int n;
+
+	if (arg == NULL) {
+		return 1U;
+	} else if ((n = strtol(arg, NULL, 10)) > 0) {
+		return (unsigned int)n;
+	}
+#if defined _SC_NPROCESSORS_ONLN
+	/* one job per processor */
+	if ((n = sysconf(_SC_NPROCESSORS_ONLN)) > 0) {
+		return (unsigned int)n;
+	}
+#endif	/* _SC_NPROCESSORS_ONLN */
+	return 1U;
+}
+
+void
+dt_io_par_prep(void)
+{
+	/* the base date and `now' are singletons, initialise them
+	 * before any of the threads gets a chance to race for it */
+	(void)dt_datetime((dt_dttyp_t)DT_YMD);
+	(void)dt_get_base();
+	/* same for the lazily loaded locales */
+	dut_need_ilocale();
+	dut_need_flocale();
+	return;
+}
+
+dt_io_par_t
+dt_io_par_init(unsigned int njobs)
+{
+	struct dt_io_par_s *res;
+
+	if (UNLIKELY(!njobs)) {
+		njobs = 1U;
+	}
+#if !defined HAVE_PTHREAD_H
+	/* no threads, no parallelism */
+	njobs = 1U;
+#endif	/* !HAVE_PTHREAD_H */
+	res = calloc(1U, sizeof(*res) + njobs * sizeof(*res->jobs));
+	if (UNLIKELY(res == NULL)) {
+		return NULL;
+	}
+	res->njobs = njobs;
+	dt_io_par_prep();
+	return res;
+}
+
+void
+dt_io_par_free(dt_io_par_t par)
+{
+	for (unsigned int i = 0U; i < par->njobs; i++) {
+		dt_io_obuf_free(&par->jobs[i].ob);
+	}
+	if (par->lines != NULL) {
+		free(par->lines);
+	}
+	free(par);
+	return;
+}
+
+int
+dt_io_par_proc(
+	dt_io_par_t par, prch_ctx_t pctx, dt_io_par_f fn, void *const clo[])
+{
+	unsigned int njobs = par->njobs;
+	size_t per;
+	int rc = 0;
+
+	if (UNLIKELY(__snarf_lines(par, pctx) < 0)) {
+		return -1;
+	}
+	/* don't bother spawning threads for short chunks */
+	if (par->nlines / MIN_LINES_PER_JOB < njobs) {
+		njobs = par->nlines / MIN_LINES_PER_JOB ?: 1U;
+	}
+	per = (par->nlines + njobs - 1U) / njobs;
+
+	for (unsigned int i = 0U; i < njobs; i++) {
+		struct job_s *j = par->jobs + i;
+		size_t beg = i * per;
+		size_t end = beg + per;
+
+		if (end > par->nlines) {
+			end = par->nlines;
+		}
+		if (beg > end) {
+			beg = end;
+		}
+		j->fn = fn;
+		j->clo = clo[i];
+		j->beg = par->lines + beg;
+		j->end = par->lines + end;
+		j->ob.bno = 0U;
+		j->rc = 0;
+	}
+
+#if defined HAVE_PTHREAD_H
+	{
+		pthread_t th[njobs];
+		unsigned int nth;
+
+		/* job 0 is done by the calling thread */
+		for (nth = 1U; nth < njobs; nth++) {
+			struct job_s *j = par->jobs + nth;
+
+			if (pthread_create(th + nth, NULL, __work, j)) {
+				break;
+			}
+		}
+		(void)__work(par->jobs);
+		for (unsigned int i = 1U; i < nth; i++) {
+			pthread_join(th[i], NULL);
+		}
+		/* do the ones we couldn't spawn threads for ourselves */
+		for (unsigned int i = nth; i < njobs; i++) {
+			(void)__work(par->jobs + i);
+		}
+	}
+#else  /* !HAVE_PTHREAD_H */
+	(void)__work(par->jobs);
+#endif	/* HAVE_PTHREAD_H */
+
+	/* flush in line order */
+	for (unsigned int i = 0U; i < njobs; i++) {
+		const struct job_s *j = par->jobs + i;
+
+		dt_io_owrite(j->ob.buf, j->ob.bno);
+		rc |= j->rc;
+	}
+	return rc;
+}
+
+/* dt-io-par.c ends here */
@@ -0,0 +1,75 @@
+/*** dt-io-par.h -- multi-threaded line processing
+ *
+ * Copyright (C) 2020 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of dateutils.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if !defined INCLUDED_dt_io_par_h_
+#define INCLUDED_dt_io_par_h_
+
+#include "dt-io.h"
+#include "prchunk.h"
+
+typedef struct dt_io_par_s *dt_io_par_t;
+
+/**
+ * Line processor for dt_io_par_proc(), CLO is the per-thread closure,
+ * output is to go to OB, the return values are or'd together. */
+typedef int(*dt_io_par_f)(void *clo, dt_io_obuf_t ob, char *line, size_t llen);
+
+/**
+ * Return the number of jobs as requested by ARG, NULL means 1,
+ * 0 means one job per online processor. */
+extern unsigned int dt_io_par_njobs(const char *arg);
+
+/**
+ * Set up the lazily initialised globals (base date, `now', locales)
+ * so that threads don't race for them, dt_io_par_init() does this. */
+extern void dt_io_par_prep(void);
+
+/**
+ * Create a parallel processor for NJOBS threads. */
+extern dt_io_par_t dt_io_par_init(unsigned int njobs);
+
+extern void dt_io_par_free(dt_io_par_t);
+
+/**
+ * Process all lines of the current chunk in PCTX.
+ * The lines are split into consecutive ranges, one per job, and
+ * FN is called on every line of a range with CLO[i] of the job at hand.
+ * Output is written to stdout in the original line order.
+ * Return the bitwise or of all FN results. */
+extern int
+dt_io_par_proc(dt_io_par_t, prch_ctx_t pctx, dt_io_par_f fn, void *const clo[]);
+
+#endif	/* INCLUDED_dt_io_par_h_ */
@@ -37,11 +37,17 @@
 #if defined HAVE_CONFIG_H
 # include "config.h"
 #endif	/* HAVE_CONFIG_H */
+#include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
+#if defined HAVE_PTHREAD_H
+# include <pthread.h>
+#endif	/* HAVE_PTHREAD_H */
 #include "tzmap.h"
 #include "dt-io.h"
 #include "dt-io-zone.h"
 #include "alist.h"
+#include "nifty.h"
 
 #if defined TZMAP_DIR
 static const char tmdir[] = TZMAP_DIR;
@@ -81,6 +87,8 @@ xstrlcpy(char *restrict dst, const char *src, size_t dsz)
 
 static struct alist_s zones[1U];
 static struct alist_s tzmaps[1U];
+/* specs we've warned about */
+static struct alist_s unknowns[1U];
 
 static tzmap_t
 find_tzmap(const char *mnm, size_t mnz)
@@ -126,6 +134,34 @@ __io_zone(const char *spec)
 	return res;
 }
 
+static tzmap_t
+__io_tzmap(const char *mnm, size_t mnz)
+{
+	char tzmfn[PATH_MAX];
+	tzmap_t tzm;
+
+	xstrlncpy(tzmfn, sizeof(tzmfn), mnm, mnz);
+
+	/* check tzmaps alist first */
+	if ((tzm = alist_assoc(tzmaps, tzmfn)) != NULL) {
+		;
+	} else if ((tzm = find_tzmap(tzmfn, mnz)) != NULL) {
+		/* cache the instance */
+		alist_put(tzmaps, tzmfn, tzm);
+	} else {
+		error("\
+Cannot find `%s" TZMAP_SUF "' in the tzmaps search path\n\
+Set TZMAP_DIR environment variable to where " TZMAP_SUF " files reside", tzmfn);
+	}
+	return tzm;
+}
+
+int
+dt_io_zone_map(const char *map)
+{
+	return __io_tzmap(map, strlen(map)) != NULL ? 0 : -1;
+}
+
 zif_t
 dt_io_zone(const char *spec)
 {
@@ -137,21 +173,9 @@ dt_io_zone(const char *spec)
 	}
 	/* see if SPEC is a MAP:KEY */
 	if ((p = strchr(spec, ':')) != NULL) {
-		char tzmfn[PATH_MAX];
 		tzmap_t tzm;
 
-		xstrlncpy(tzmfn, sizeof(tzmfn), spec, p - spec);
-
-		/* check tzmaps alist first */
-		if ((tzm = alist_assoc(tzmaps, tzmfn)) != NULL) {
-			;
-		} else if ((tzm = find_tzmap(tzmfn, p - spec)) != NULL) {
-			/* cache the instance */
-			alist_put(tzmaps, tzmfn, tzm);
-		} else {
-			error("\
-Cannot find `%s" TZMAP_SUF "' in the tzmaps search path\n\
-Set TZMAP_DIR environment variable to where " TZMAP_SUF " files reside", tzmfn);
+		if ((tzm = __io_tzmap(spec, p - spec)) == NULL) {
 			return NULL;
 		}
 		/* look up key bit in tzmap and use that if found */
@@ -177,7 +201,173 @@ dt_io_clear_zones(void)
 		}
 		free_alist(zones);
 	}
+	free_alist(unknowns);
+	return;
+}
+
+
+/* zone caches */
+struct zc_slot_s {
+	uint32_t h;
+	uint32_t kz;
+	char *key;
+	zif_t z;
+};
+
+struct dt_io_zcache_s {
+	size_t nslot;
+	size_t nused;
+	struct zc_slot_s *slot;
+	size_t mz;
+	char map[];
+};
+
+#if defined HAVE_PTHREAD_H
+/* the alists behind dt_io_zone() are shared */
+static pthread_mutex_t zmtx = PTHREAD_MUTEX_INITIALIZER;
+#endif	/* HAVE_PTHREAD_H */
+
+static inline uint32_t
+zc_hash(const char *s, size_t z)
+{
+/* 32bit FNV-1a */
+	uint32_t h = 2166136261U;
+
+	for (size_t i = 0U; i < z; i++) {
+		h ^= (unsigned char)s[i];
+		h *= 16777619U;
+	}
+	return h;
+}
+
+static zif_t
+zc_resolve(dt_io_zcache_t zc, const char *spec, size_t ssz)
+{
+	char buf[PATH_MAX];
+	size_t bz = 0U;
+	zif_t res;
+
+	if (zc->mz) {
+		bz = xstrlncpy(buf, sizeof(buf), zc->map, zc->mz);
+		buf[bz++] = ':';
+	}
+	if (bz + ssz >= sizeof(buf)) {
+		return NULL;
+	}
+	xstrlncpy(buf + bz, sizeof(buf) - bz, spec, ssz);
+
+#if defined HAVE_PTHREAD_H
+	pthread_mutex_lock(&zmtx);
+#endif	/* HAVE_PTHREAD_H */
+	if ((res = dt_io_zone(buf)) == NULL &&
+	    alist_assoc(unknowns, buf) == NULL) {
+		/* tell them, but only once per spec and process */
+		error("\
+Warning: cannot use `%s', it does not appear to be a zonename", buf);
+		alist_put(unknowns, buf, unknowns);
+	}
+#if defined HAVE_PTHREAD_H
+	pthread_mutex_unlock(&zmtx);
+#endif	/* HAVE_PTHREAD_H */
+	return res;
+}
+
+static int
+zc_grow(dt_io_zcache_t zc)
+{
+	size_t nsl = zc->nslot * 2U;
+	struct zc_slot_s *sl;
+
+	if (UNLIKELY((sl = calloc(nsl, sizeof(*sl))) == NULL)) {
+		return -1;
+	}
+	for (size_t i = 0U; i < zc->nslot; i++) {
+		const struct zc_slot_s s = zc->slot[i];
+
+		if (s.key == NULL) {
+			continue;
+		}
+		for (size_t j = s.h;; j++) {
+			if (sl[j &= nsl - 1U].key == NULL) {
+				sl[j] = s;
+				break;
+			}
+		}
+	}
+	free(zc->slot);
+	zc->slot = sl;
+	zc->nslot = nsl;
+	return 0;
+}
+
+dt_io_zcache_t
+dt_io_zcache_init(const char *map)
+{
+	size_t mz = map != NULL ? strlen(map) : 0U;
+	dt_io_zcache_t res;
+
+	if (UNLIKELY((res = malloc(sizeof(*res) + mz + 1U)) == NULL)) {
+		return NULL;
+	} else if (UNLIKELY((res->slot = calloc(16U, sizeof(*res->slot))) ==
+			    NULL)) {
+		free(res);
+		return NULL;
+	}
+	res->nslot = 16U;
+	res->nused = 0U;
+	res->mz = mz;
+	memcpy(res->map, map ?: "", mz + 1U);
+	return res;
+}
+
+void
+dt_io_zcache_free(dt_io_zcache_t zc)
+{
+	if (UNLIKELY(zc == NULL)) {
+		return;
+	}
+	for (size_t i = 0U; i < zc->nslot; i++) {
+		free(zc->slot[i].key);
+	}
+	free(zc->slot);
+	free(zc);
 	return;
 }
 
+zif_t
+dt_io_zcache_get(dt_io_zcache_t zc, const char *spec, size_t ssz)
+{
+	const uint32_t h = zc_hash(spec, ssz);
+	zif_t z;
+	char *k;
+	size_t i;
+
+	if (UNLIKELY(zc == NULL)) {
+		return NULL;
+	}
+	for (i = h;; i++) {
+		const struct zc_slot_s *s = zc->slot + (i &= zc->nslot - 1U);
+
+		if (s->key == NULL) {
+			break;
+		} else if (s->h == h && s->kz == ssz &&
+			   !memcmp(s->key, spec, ssz)) {
+			return s->z;
+		}
+	}
+	/* not seen before, unknown specs are remembered as well */
+	z = zc_resolve(zc, spec, ssz);
+	if (UNLIKELY((k = malloc(ssz + 1U)) == NULL)) {
+		return z;
+	}
+	memcpy(k, spec, ssz);
+	k[ssz] = '\0';
+	zc->slot[i] = (struct zc_slot_s){h, (uint32_t)ssz, k, z};
+	/* keep the load factor below 1/2 */
+	if (++zc->nused * 2U >= zc->nslot) {
+		(void)zc_grow(zc);
+	}
+	return z;
+}
+
 /* dt-io-zone.c ends here */
@@ -41,6 +41,30 @@
 
 extern zif_t dt_io_zone(const char *spec);
 
+/**
+ * Open the tzmap MAP for later MAP:KEY specs, complain if there's none.
+ * Return 0 on success, -1 otherwise. */
+extern int dt_io_zone_map(const char *map);
+
 extern void dt_io_clear_zones(void);
 
+/* per-line zone lookups */
+typedef struct dt_io_zcache_s *dt_io_zcache_t;
+
+/**
+ * Create a cache for zone specs, if MAP is non-NULL specs are looked
+ * up as MAP:SPEC.  Caches are not to be shared between threads. */
+extern dt_io_zcache_t dt_io_zcache_init(const char *map);
+
+/**
+ * Free the cache, zones obtained through it stay valid until
+ * dt_io_clear_zones(). */
+extern void dt_io_zcache_free(dt_io_zcache_t);
+
+/**
+ * Return the zone for SPEC of length SSZ, or NULL if there's none.
+ * Hits cost a hash and a compare, misses (including unknown specs)
+ * are resolved through dt_io_zone() once and remembered. */
+extern zif_t dt_io_zcache_get(dt_io_zcache_t, const char *spec, size_t ssz);
+
 #endif	/* INCLUDED_dt_io_zone_h_ */
@@ -13,6 +13,12 @@
 #include <strings.h>
 #include <stdarg.h>
 #include <errno.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <time.h>
+#if defined HAVE_IMMINTRIN_H
+# include <immintrin.h>
+#endif	/* HAVE_IMMINTRIN_H */
 #include "dt-core.h"
 #include "dt-core-tz-glue.h"
 #include "date-core-private.h"
@@ -33,6 +39,20 @@
 # pragma GCC diagnostic ignored "-Wcast-qual"
 #endif	/* __INTEL_COMPILER */
 
+#if defined HAVE___M128I && defined __SSE2__
+# define DT_IO_SSE2
+#endif	/* __m128i && SSE2 */
+
+/* digit maps, only the first DGMAP_LEN bytes of a line are mapped */
+#define DGMAP_LEN	(512U)
+
+struct dgmap_s {
+	/* number of bytes mapped */
+	size_t n;
+	/* bit I is set iff byte I is a digit */
+	uint64_t m[DGMAP_LEN / 64U];
+};
+
 
 /* our own perror() implementation */
 void
@@ -68,9 +88,113 @@ serror(const char *fmt, ...)
 	return;
 }
 
+void
+dt_io_timing(const char *phase)
+{
+	static int onp = -1;
+	static struct timespec last;
+	struct timespec now;
+
+	if (LIKELY(!onp)) {
+		return;
+	} else if (onp < 0 && !(onp = getenv("DT_TIMINGS") != NULL)) {
+		return;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	if (phase != NULL) {
+		long int us = (now.tv_sec - last.tv_sec) * 1000000L +
+			(now.tv_nsec - last.tv_nsec) / 1000L;
+
+		error("timing: %-8s %8ldus", phase, us);
+		/* don't bill the next phase for our own output */
+		clock_gettime(CLOCK_MONOTONIC, &now);
+	}
+	last = now;
+	return;
+}
+
 
 #include "strpdt-special.c"
 
+/* compiled formats, compiled upon first use and shared by all threads,
+ * keyed by the format's text rather than its address as buffers get
+ * reused, each program is compiled from the entry's own copy of the
+ * text so it can't go stale, entries are only ever prepended */
+struct fmtc_s {
+	const struct fmtc_s *next;
+	dt_fmt_t prg;
+	char fmt[];
+};
+
+static const struct fmtc_s *fmtc;
+
+static dt_fmt_t
+dt_io_fmtc(const char *fmt)
+{
+	const struct fmtc_s *c = __atomic_load_n(&fmtc, __ATOMIC_ACQUIRE);
+	struct fmtc_s *nu;
+	size_t z;
+
+	for (; c != NULL; c = c->next) {
+		if (LIKELY(!strcmp(c->fmt, fmt))) {
+			return c->prg;
+		}
+	}
+	z = strlen(fmt) + 1U;
+	if (UNLIKELY((nu = malloc(sizeof(*nu) + z)) == NULL)) {
+		return NULL;
+	}
+	memcpy(nu->fmt, fmt, z);
+	if (UNLIKELY((nu->prg = dt_fmt_compile(nu->fmt)) == NULL)) {
+		free(nu);
+		return NULL;
+	}
+	/* publish, should another thread beat us to it with the same
+	 * format there'll be two entries which does no harm */
+	nu->next = __atomic_load_n(&fmtc, __ATOMIC_RELAXED);
+	while (!__atomic_compare_exchange_n(
+		       &fmtc, &nu->next, nu, true,
+		       __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+	return nu->prg;
+}
+
+static inline struct dt_dt_s
+__io_strpdt(const char *str, const char *fmt, char **ep)
+{
+	dt_fmt_t prg;
+
+	if (fmt == NULL || (prg = dt_io_fmtc(fmt)) == NULL) {
+		return dt_strpdt(str, fmt, ep);
+	}
+	return dt_strpdt_c(str, prg, ep);
+}
+
+static inline size_t
+__io_strfdt(char *restrict buf, size_t bsz, const char *fmt, struct dt_dt_s d)
+{
+	dt_fmt_t prg;
+
+	if (fmt == NULL || (prg = dt_io_fmtc(fmt)) == NULL) {
+		return dt_strfdt(buf, bsz, fmt, d);
+	}
+	return dt_strfdt_c(buf, bsz, prg, d);
+}
+
+/* formatter */
+static inline size_t
+dt_io_strfdt(
+	char *restrict buf, size_t bsz,
+	const char *fmt, struct dt_dt_s that, int apnd_ch)
+{
+	size_t res = __io_strfdt(buf, bsz, fmt, that);
+
+	if (LIKELY(res > 0) && apnd_ch && buf[res - 1] != apnd_ch) {
+		/* auto-newline */
+		buf[res++] = (char)apnd_ch;
+	}
+	return res;
+}
+
 dt_strpdt_special_t
 dt_io_strpdt_special(const char *str)
 {
@@ -127,7 +251,7 @@ dt_io_strpdt(
 		res = dt_strpdt(str, NULL, NULL);
 	} else {
 		for (size_t i = 0; i < nfmt; i++) {
-			if (!dt_unk_p(res = dt_strpdt(str, fmt[i], NULL))) {
+			if (!dt_unk_p(res = __io_strpdt(str, fmt[i], NULL))) {
 				break;
 			}
 		}
@@ -147,7 +271,7 @@ dt_io_strpdt_ep(
 		res = dt_strpdt(str, NULL, ep);
 	} else {
 		for (size_t i = 0; i < nfmt; i++) {
-			if (!dt_unk_p(res = dt_strpdt(str, fmt[i], ep))) {
+			if (!dt_unk_p(res = __io_strpdt(str, fmt[i], ep))) {
 				break;
 			}
 		}
@@ -175,6 +299,71 @@ dt_io_find_strpdt(
 	return d;
 }
 
+static void
+__io_dgmap(struct dgmap_s *restrict map, const char *s, size_t n)
+{
+/* map the digits in S (of N bytes) */
+	map->n = n < DGMAP_LEN ? n : DGMAP_LEN;
+	for (size_t i = 0U; i < map->n; i += 64U) {
+		const size_t nj = map->n - i < 64U ? map->n - i : 64U;
+		uint64_t w = 0U;
+		size_t j = 0U;
+
+#if defined DT_IO_SSE2
+		for (; j + sizeof(__m128i) <= nj; j += sizeof(__m128i)) {
+			/* digits become 0 to 9, anything else is bigger */
+			__m128i x = _mm_sub_epi8(
+				_mm_loadu_si128((const void*)(s + i + j)),
+				_mm_set1_epi8('0'));
+			__m128i y = _mm_cmpeq_epi8(
+				_mm_min_epu8(x, _mm_set1_epi8(9)), x);
+
+			w |= (uint64_t)_mm_movemask_epi8(y) << j;
+		}
+#endif	/* DT_IO_SSE2 */
+		for (; j < nj; j++) {
+			const char c = s[i + j];
+
+			w |= (uint64_t)(c >= '0' && c <= '9') << j;
+		}
+		map->m[i / 64U] = w;
+	}
+	return;
+}
+
+static size_t
+__io_dgfind(
+	const struct dgmap_s *map, const char *s, size_t n, size_t i, bool dgp)
+{
+/* return the offset of the first byte of S (of N bytes) from I onwards
+ * that is a digit (DGP) or isn't one (!DGP), or N if there's none */
+	const size_t beg = i;
+
+	for (; i < map->n; i = (i | 63U) + 1U) {
+		uint64_t w = dgp ? map->m[i / 64U] : ~map->m[i / 64U];
+
+		/* bits below I don't count */
+		if ((w &= ~0ULL << (i % 64U))) {
+			i = (i & ~(size_t)63U) + __builtin_ctzll(w);
+			break;
+		}
+	}
+	if (i < map->n) {
+		return i;
+	}
+	/* bytes past the map are checked one by one */
+	for (i = beg > map->n ? beg : map->n;
+	     i < n && (s[i] >= '0' && s[i] <= '9') != dgp; i++);
+	return i;
+}
+
+static inline bool
+__io_stdlead_p(char c)
+{
+/* whether a standard date/time may begin with C */
+	return (c >= '0' && c <= '9') || c == '@';
+}
+
 struct dt_dt_s
 dt_io_find_strpdt2(
 	const char *str, size_t len,
@@ -186,6 +375,8 @@ dt_io_find_strpdt2(
 	const char *needle = needles->needle;
 	const char *p = str;
 	const char *const zp = str + len;
+	struct dgmap_s dgm;
+	bool dgmp = false;
 
 	for (; *(p = xmempbrk(p, zp - p, needle)); p++) {
 		/* find the offset */
@@ -207,7 +398,11 @@ dt_io_find_strpdt2(
 			}
 
 			for (; q < zp && q <= r; q++) {
-				if (!dt_unk_p(d = dt_strpdt(q, fmt, ep))) {
+				if (fmt == NULL && !__io_stdlead_p(*q)) {
+					/* don't bother the parser */
+					continue;
+				}
+				if (!dt_unk_p(d = __io_strpdt(q, fmt, ep))) {
 					p = q;
 					goto found;
 				}
@@ -247,12 +442,21 @@ dt_io_find_strpdt2(
 			break;
 
 		case GRPATM_DIGITS:
-			/* yay, look for all digits */
-			for (p = str; p < zp && !(*p >= '0' && *p <= '9'); p++);
-			for (const char *q = p;
-			     q < zp && *q >= '0' && *q <= '9'; q++) {
-				if ((--f.off_min <= 0) &&
-				    !dt_unk_p(d = dt_strpdt(p, fmt, ep))) {
+			/* yay, look for all digits, try every run that's
+			 * long enough at its beginning, for digit atoms
+			 * calc_grep_atom() turns OFF_MIN into the least
+			 * number of digits the format takes */
+			if (!dgmp) {
+				__io_dgmap(&dgm, str, len);
+				dgmp = true;
+			}
+			for (size_t b = 0U, e;
+			     (b = __io_dgfind(&dgm, str, len, b, true)) < len;
+			     b = e) {
+				e = __io_dgfind(&dgm, str, len, b, false);
+				if ((ptrdiff_t)(e - b) >= f.off_min &&
+				    !dt_unk_p(d = __io_strpdt(
+						      p = str + b, fmt, ep))) {
 					goto found;
 				}
 			}
@@ -285,7 +489,7 @@ dt_io_find_strpdt2(
 					goto bugger;
 				}
 				if ((--f.off_min <= 0) &&
-				    !dt_unk_p(d = dt_strpdt(p, fmt, ep))) {
+				    !dt_unk_p(d = __io_strpdt(p, fmt, ep))) {
 					goto found;
 				}
 			}
@@ -299,7 +503,7 @@ dt_io_find_strpdt2(
 				continue;
 			}
 			for (int8_t j = f.off_min; j <= f.off_max; j++) {
-				if (!dt_unk_p(d = dt_strpdt(p + j, fmt, ep))) {
+				if (!dt_unk_p(d = __io_strpdt(p + j, fmt, ep))) {
 					p += j;
 					goto found;
 				}
@@ -313,12 +517,11 @@ found:
 	return dtz_forgetz(d, zone);
 }
 
-int
-dt_io_write(struct dt_dt_s d, const char *fmt, zif_t zone, int apnd_ch)
-{
-	static char buf[256];
-	size_t n;
+#define DT_IO_MAXLEN	(256U)
 
+static inline struct dt_dt_s
+__io_outz(struct dt_dt_s d, zif_t zone)
+{
 	if (zone != NULL) {
 		d = dtz_enrichz(d, zone);
 	} else {
@@ -326,11 +529,169 @@ dt_io_write(struct dt_dt_s d, const char *fmt, zif_t zone, int apnd_ch)
 		d.zdiff = 0U;
 		d.neg = 0U;
 	}
-	n = dt_io_strfdt(buf, sizeof(buf), fmt, d, apnd_ch);
-	__io_write(buf, n, stdout);
+	return d;
+}
+
+/* the stdout sink, flushed in blocks of DT_IO_SINKSZ bytes,
+ * or after every write if stdout is a terminal */
+#define DT_IO_SINKSZ	(256U * 1024U)
+static struct dt_io_obuf_s sink;
+static int sink_ttyp;
+
+static void
+sink_fini(void)
+{
+	(void)dt_io_flush();
+	dt_io_obuf_free(&sink);
+	return;
+}
+
+static dt_io_obuf_t
+sink_get(void)
+{
+	static int initp;
+
+	if (UNLIKELY(!initp)) {
+		sink_ttyp = isatty(STDOUT_FILENO);
+		atexit(sink_fini);
+		initp = 1;
+	}
+	return &sink;
+}
+
+static int
+sink_writev(const char *x, size_t xn)
+{
+/* write out the sink followed by X of size XN */
+	struct iovec v[2U] = {
+		{.iov_base = sink.buf, .iov_len = sink.bno},
+		{.iov_base = (void*)x, .iov_len = xn},
+	};
+	struct iovec *vp = v;
+	int nv = countof(v);
+	int rc = 0;
+
+	/* anything stdio has buffered goes first */
+	fflush(stdout);
+	while (nv > 0) {
+		ssize_t nwr = writev(STDOUT_FILENO, vp, nv);
+
+		if (UNLIKELY(nwr < 0 && errno == EINTR)) {
+			continue;
+		} else if (UNLIKELY(nwr < 0)) {
+			rc = -1;
+			break;
+		}
+		for (; nv > 0 && (size_t)nwr >= vp->iov_len; vp++, nv--) {
+			nwr -= vp->iov_len;
+		}
+		if (nv > 0) {
+			vp->iov_base = (char*)vp->iov_base + nwr;
+			vp->iov_len -= nwr;
+		}
+	}
+	sink.bno = 0U;
+	return rc;
+}
+
+static inline int
+sink_check(void)
+{
+	if (UNLIKELY(sink.bno >= DT_IO_SINKSZ || sink_ttyp)) {
+		return sink_writev(NULL, 0U);
+	}
+	return 0;
+}
+
+int
+dt_io_write(struct dt_dt_s d, const char *fmt, zif_t zone, int apnd_ch)
+{
+	int rc = dt_io_bwrite(d, fmt, zone, apnd_ch, sink_get());
+
+	if (UNLIKELY(sink_check() < 0)) {
+		return -1;
+	}
+	return rc;
+}
+
+size_t
+dt_io_owrite(const char *line, size_t llen)
+{
+	dt_io_obuf_t ob = sink_get();
+	char *p;
+
+	if (UNLIKELY(llen >= DT_IO_SINKSZ)) {
+		/* don't bother copying */
+		return sink_writev(line, llen) < 0 ? 0U : llen;
+	} else if (UNLIKELY((p = dt_io_obuf_ensure(ob, llen)) == NULL)) {
+		return 0U;
+	}
+	memcpy(p, line, llen);
+	ob->bno += llen;
+	if (UNLIKELY(sink_check() < 0)) {
+		return 0U;
+	}
+	return llen;
+}
+
+int
+dt_io_flush(void)
+{
+	if (sink.bno == 0U) {
+		return fflush(stdout);
+	}
+	return sink_writev(NULL, 0U);
+}
+
+int
+dt_io_bwrite(
+	struct dt_dt_s d, const char *fmt, zif_t zone, int apnd_ch,
+	dt_io_obuf_t ob)
+{
+	char *p;
+	size_t n;
+
+	if (ob == NULL) {
+		return dt_io_write(d, fmt, zone, apnd_ch);
+	} else if (UNLIKELY(!(p = dt_io_obuf_ensure(ob, DT_IO_MAXLEN)))) {
+		return -1;
+	}
+	/* format directly into the buffer */
+	d = __io_outz(d, zone);
+	n = dt_io_strfdt(p, DT_IO_MAXLEN, fmt, d, apnd_ch);
+	ob->bno += n;
 	return (n > 0) - 1;
 }
 
+char*
+dt_io_obuf_ensure(dt_io_obuf_t ob, size_t n)
+{
+	if (UNLIKELY(ob->bno + n > ob->bsz)) {
+		size_t nu = ob->bsz ?: 65536U;
+		char *tmp;
+
+		while (ob->bno + n > nu) {
+			nu *= 2U;
+		}
+		if (UNLIKELY((tmp = realloc(ob->buf, nu)) == NULL)) {
+			return NULL;
+		}
+		ob->buf = tmp;
+		ob->bsz = nu;
+	}
+	return ob->buf + ob->bno;
+}
+
+void
+dt_io_obuf_free(dt_io_obuf_t ob)
+{
+	if (ob->buf != NULL) {
+		free(ob->buf);
+	}
+	memset(ob, 0, sizeof(*ob));
+	return;
+}
+
 
 /* needles for the grep mode */
 struct grep_atom_s
@@ -451,6 +812,7 @@ calc_grep_atom(const char *fmt)
 			res.pl.flags |= GRPATM_DIGITS;
 			break;
 		case DT_SPFL_S_WDAY:
+			dut_need_ilocale();
 			if (res.pl.off_min == res.pl.off_max) {
 				andl_idx = res.pl.off_min;
 			}
@@ -475,6 +837,7 @@ calc_grep_atom(const char *fmt)
 			}
 			break;
 		case DT_SPFL_S_MON:
+			dut_need_ilocale();
 			if (res.pl.off_min == res.pl.off_max) {
 				bndl_idx = res.pl.off_min;
 			}
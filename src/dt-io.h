@@ -58,6 +58,17 @@ struct grep_atom_soa_s {
 	struct grpatm_payload_s *flesh;
 };
 
+/* output buffers, used by the multi-threaded line processors,
+ * every thread writes into its own buffer which is then flushed
+ * in the original line order */
+typedef struct dt_io_obuf_s *dt_io_obuf_t;
+
+struct dt_io_obuf_s {
+	char *buf;
+	size_t bsz;
+	size_t bno;
+};
+
 /* duration parser */
 /* we parse durations ourselves so we can cope with the
  * non-commutativity of duration addition:
@@ -100,9 +111,36 @@ dt_io_find_strpdt2(
 	char **sp, char **ep,
 	zif_t zone);
 
+/**
+ * Format D according to FMT in ZONE and append it to the stdout sink.
+ * The sink bypasses stdio and is written out in large blocks,
+ * when full, at exit or upon dt_io_flush(). */
 extern int
 dt_io_write(struct dt_dt_s d, const char *fmt, zif_t zone, int apnd_ch);
 
+/**
+ * Append LINE of length LLEN to the stdout sink. */
+extern size_t dt_io_owrite(const char *line, size_t llen);
+
+/**
+ * Write out the stdout sink, return 0 on success, -1 otherwise. */
+extern int dt_io_flush(void);
+
+/**
+ * Like dt_io_write() but append to output buffer OB.
+ * If OB is NULL the result is appended to the stdout sink. */
+extern int
+dt_io_bwrite(
+	struct dt_dt_s d, const char *fmt, zif_t zone, int apnd_ch,
+	dt_io_obuf_t ob);
+
+/**
+ * Make sure there's room for at least N more bytes in OB,
+ * return a pointer to the first free byte or NULL on failure. */
+extern char *dt_io_obuf_ensure(dt_io_obuf_t ob, size_t n);
+
+extern void dt_io_obuf_free(dt_io_obuf_t ob);
+
 /* grep atoms */
 extern struct grep_atom_s calc_grep_atom(const char *fmt);
 
@@ -117,6 +155,12 @@ extern __attribute__((format(printf, 1, 2))) void error(const char *fmt, ...);
 /* error messages, warnings, etc. */
 extern __attribute__((format(printf, 1, 2))) void serror(const char *fmt, ...);
 
+/**
+ * If the environment has DT_TIMINGS set, report the time spent since
+ * the previous call as startup phase PHASE on stderr.
+ * Call with NULL first to mark the beginning. */
+extern void dt_io_timing(const char *phase);
+
 /* for error() above, use PROG as name for the tool. */
 extern const char *prog;
 
@@ -141,21 +185,6 @@ make_grep_atom_soa(grep_atom_t atoms, size_t natoms)
 
 #define GRPATM_NEEDLELESS_MODE_CHAR	(1)
 
-/* formatter */
-static inline size_t
-dt_io_strfdt(
-	char *restrict buf, size_t bsz,
-	const char *fmt, struct dt_dt_s that, int apnd_ch)
-{
-	size_t res = dt_strfdt(buf, bsz, fmt, that);
-
-	if (LIKELY(res > 0) && apnd_ch && buf[res - 1] != apnd_ch) {
-		/* auto-newline */
-		buf[res++] = (char)apnd_ch;
-	}
-	return res;
-}
-
 
 static __attribute__((unused)) size_t
 __io_write(const char *line, size_t llen, FILE *where)
@@ -167,6 +196,21 @@ __io_write(const char *line, size_t llen, FILE *where)
 #endif	/* __GLIBC__ */
 }
 
+static __attribute__((unused)) size_t
+__io_bwrite(const char *line, size_t llen, dt_io_obuf_t ob)
+{
+	char *p;
+
+	if (ob == NULL) {
+		return dt_io_owrite(line, llen);
+	} else if (UNLIKELY((p = dt_io_obuf_ensure(ob, llen)) == NULL)) {
+		return 0U;
+	}
+	memcpy(p, line, llen);
+	ob->bno += llen;
+	return llen;
+}
+
 static __attribute__((unused)) int
 __io_putc(int c, FILE *where)
 {
@@ -64,6 +64,7 @@ main(int argc, char *argv[])
 	zif_t fromz = NULL;
 	int res = 0;
 
+	dt_io_timing(NULL);
 	if (yuck_parse(argi, argc, argv)) {
 		res = 2;
 		goto out;
@@ -75,9 +76,11 @@ main(int argc, char *argv[])
 		res = 2;
 		goto out;
 	}
+	dt_io_timing("options");
 	if (argi->from_locale_arg) {
 		setilocale(argi->from_locale_arg);
 	}
+	dt_io_timing("locale");
 	if (argi->from_zone_arg) {
 		fromz = dt_io_zone(argi->from_zone_arg);
 	}
@@ -85,6 +88,7 @@ main(int argc, char *argv[])
 		struct dt_dt_s base = dt_strpdt(argi->base_arg, NULL, NULL);
 		dt_set_base(base);
 	}
+	dt_io_timing("zones");
 
 	ifmt = argi->input_format_args;
 	nifmt = argi->input_format_nargs;
@@ -142,10 +146,12 @@ main(int argc, char *argv[])
 		res = res == 1 || res == 0 ? 0 : 1;
 	}
 out:
+	dt_io_timing("process");
 	dt_io_clear_zones();
 	if (argi->from_locale_arg) {
 		setilocale(NULL);
 	}
+	dt_io_timing("cleanup");
 
 	yuck_free(argi);
 	return res;
@@ -50,16 +50,21 @@
 #include "tzraw.h"
 
 struct ztr_s {
-	int32_t trns;
+	int64_t trns;
 	int32_t offs;
 };
 
-/* fwd decld in tzraw.h */
-struct ztrdtl_s {
-	int32_t offs;
-	uint8_t dstp;
-	uint8_t abbr;
-} __attribute__((packed));
+struct dz_zone_s {
+	zif_t zone;
+	const char *name;
+};
+
+/* per-zone transition streams, merged through a binary heap */
+struct dz_trst_s {
+	struct ztrit_s it;
+	struct ztr64_s tr;
+	size_t zi;
+};
 
 const char *prog = "dzone";
 static char gbuf[256U];
@@ -129,7 +134,7 @@ dz_io_write(struct dt_dt_s d, zif_t zone, const char *name)
 		bp += xstrlcpy(bp, name, ep - bp);
 	}
 	*bp++ = '\n';
-	__io_write(gbuf, bp - gbuf, stdout);
+	dt_io_owrite(gbuf, bp - gbuf);
 	return (bp > gbuf) - 1;
 }
 
@@ -151,29 +156,24 @@ dz_strftr(char *restrict buf, size_t bsz, struct ztr_s t)
 }
 
 static int
-dz_write_nxtr(struct zrng_s r, zif_t z, const char *zn)
+dz_write_nxtr(struct zrng64_s r, zif_t z, const char *zn)
 {
 	char *restrict bp = gbuf;
 	const char *const ep = gbuf + sizeof(gbuf);
-	size_t ntr = zif_ntrans(z);
 
-	if (r.next == INT_MAX) {
+	if (r.next == INT64_MAX) {
 		bp += xstrlcpy(bp, never, bp - ep);
 	} else {
 		bp += dz_strftr(bp, ep - bp, (struct ztr_s){r.next, r.offs});
 	}
 	/* append next indicator */
 	bp += xstrlcpy(bp, nindi, bp - ep);
-	if (r.trno + 1U < ntr) {
-		/* thank god there's another one */
-		struct ztrdtl_s zd = zif_trdtl(z, r.trno + 1);
+	if (r.next != INT64_MAX) {
+		/* thank god there's another one, stored or by the rules */
+		struct zrng64_s nx = zif_find_zrng64(z, r.next);
 
-		if (r.next == INT_MAX) {
-			goto never;
-		}
-		bp += dz_strftr(bp, ep - bp, (struct ztr_s){r.next, zd.offs});
+		bp += dz_strftr(bp, ep - bp, (struct ztr_s){r.next, nx.offs});
 	} else {
-	never:
 		bp += xstrlcpy(bp, never, bp - ep);
 	}
 
@@ -183,27 +183,27 @@ dz_write_nxtr(struct zrng_s r, zif_t z, const char *zn)
 		bp += xstrlcpy(bp, zn, ep - bp);
 	}
 	*bp++ = '\n';
-	__io_write(gbuf, bp - gbuf, stdout);
+	dt_io_owrite(gbuf, bp - gbuf);
 	return (bp > gbuf) - 1;
 }
 
 static int
-dz_write_prtr(struct zrng_s r, zif_t UNUSED(z), const char *zn)
+dz_write_prtr(struct zrng64_s r, zif_t z, const char *zn)
 {
 	char *restrict bp = gbuf;
 	const char *const ep = gbuf + sizeof(gbuf);
 
 	if (r.trno >= 1) {
 		/* there's one before that */
-		struct ztrdtl_s zd = zif_trdtl(z, r.trno - 1);
+		struct zrng64_s pr = zif_find_zrng64(z, r.prev - 1);
 
-		bp += dz_strftr(bp, ep - bp, (struct ztr_s){r.prev, zd.offs});
+		bp += dz_strftr(bp, ep - bp, (struct ztr_s){r.prev, pr.offs});
 	} else {
 		bp += xstrlcpy(bp, never, bp - ep);
 	}
 	/* append prev indicator */
 	bp += xstrlcpy(bp, pindi, bp - ep);
-	if (r.prev == INT_MIN) {
+	if (r.prev == INT64_MIN) {
 		bp += xstrlcpy(bp, never, bp - ep);
 	} else {
 		bp += dz_strftr(bp, ep - bp, (struct ztr_s){r.prev, r.offs});
@@ -215,10 +215,88 @@ dz_write_prtr(struct zrng_s r, zif_t UNUSED(z), const char *zn)
 		bp += xstrlcpy(bp, zn, ep - bp);
 	}
 	*bp++ = '\n';
-	__io_write(gbuf, bp - gbuf, stdout);
+	dt_io_owrite(gbuf, bp - gbuf);
+	return (bp > gbuf) - 1;
+}
+static int
+dz_write_tr(struct ztr64_s tr, const char *zn)
+{
+	char *restrict bp = gbuf;
+	const char *const ep = gbuf + sizeof(gbuf);
+
+	bp += dz_strftr(bp, ep - bp, (struct ztr_s){tr.t, tr.from});
+	bp += xstrlcpy(bp, nindi, ep - bp);
+	bp += dz_strftr(bp, ep - bp, (struct ztr_s){tr.t, tr.to});
+
+	/* append name */
+	if (LIKELY(zn != NULL)) {
+		*bp++ = '\t';
+		bp += xstrlcpy(bp, zn, ep - bp);
+	}
+	*bp++ = '\n';
+	dt_io_owrite(gbuf, bp - gbuf);
 	return (bp > gbuf) - 1;
 }
 
+static inline bool
+dz_trst_lt(const struct dz_trst_s *a, const struct dz_trst_s *b)
+{
+	return a->tr.t < b->tr.t || (a->tr.t == b->tr.t && a->zi < b->zi);
+}
+
+static void
+dz_trst_sift(struct dz_trst_s *restrict h, size_t n, size_t i)
+{
+	for (size_t c; (c = 2U * i + 1U) < n; i = c) {
+		struct dz_trst_s tmp;
+
+		if (c + 1U < n && dz_trst_lt(h + c + 1U, h + c)) {
+			c++;
+		}
+		if (!dz_trst_lt(h + c, h + i)) {
+			break;
+		}
+		tmp = h[i], h[i] = h[c], h[c] = tmp;
+	}
+	return;
+}
+
+static int
+dz_write_range(const struct dz_zone_s *z, size_t nz, int64_t from, int64_t till)
+{
+/* write all transitions in [FROM, TILL) of all zones Z in time order */
+	struct dz_trst_s *h;
+	size_t n = 0U;
+
+	if (UNLIKELY((h = malloc(nz * sizeof(*h))) == NULL)) {
+		return -1;
+	}
+	for (size_t j = 0U; j < nz; j++) {
+		if (UNLIKELY(z[j].zone == NULL)) {
+			/* don't bother */
+			continue;
+		}
+		zif_trit_init(&h[n].it, z[j].zone, from, till);
+		if (zif_trit_next(&h[n].it, &h[n].tr) < 0) {
+			continue;
+		}
+		h[n++].zi = j;
+	}
+	for (size_t i = n / 2U; i-- > 0U;) {
+		dz_trst_sift(h, n, i);
+	}
+	while (n > 0U) {
+		dz_write_tr(h->tr, z[h->zi].name);
+		if (zif_trit_next(&h->it, &h->tr) < 0) {
+			/* stream's dry, replace by the last one */
+			*h = h[--n];
+		}
+		dz_trst_sift(h, n, 0U);
+	}
+	free(h);
+	return 0;
+}
+
 
 #include "dzone.yucc"
 
@@ -231,10 +309,7 @@ main(int argc, char *argv[])
 	char **fmt;
 	size_t nfmt;
 	/* all them zones to consider */
-	struct {
-		zif_t zone;
-		const char *name;
-	} *z = NULL;
+	struct dz_zone_s *z = NULL;
 	size_t nz = 0U;
 	/* all them datetimes to consider */
 	struct dt_dt_s *d = NULL;
@@ -258,7 +333,7 @@ main(int argc, char *argv[])
 	if (argi->from_zone_arg) {
 		fromz = dt_io_zone(argi->from_zone_arg);
 	}
-	if (argi->next_flag || argi->prev_flag) {
+	if (argi->next_flag || argi->prev_flag || argi->range_flag) {
 		trnsp = true;
 	}
 	if (argi->base_arg) {
@@ -317,7 +392,21 @@ nor a date/time corresponding to the given input formats", inp);
 	}
 
 	/* just go through them all now */
-	if (LIKELY(!trnsp)) {
+	if (argi->range_flag) {
+		struct dt_dt_s from = dt_dtconv(DT_SEXY, d[0U]);
+		struct dt_dt_s till;
+
+		if (nd < 2U) {
+			error("--range needs two DATE/TIMEs");
+			rc = 1;
+			goto out;
+		}
+		till = dt_dtconv(DT_SEXY, d[1U]);
+		if (dz_write_range(z, nz, from.sexy, till.sexy) < 0) {
+			error("failed to allocate space for transitions");
+			rc = 1;
+		}
+	} else if (LIKELY(!trnsp)) {
 		for (size_t i = 0U; !trnsp && i < nd; i++) {
 			for (size_t j = 0U; j < nz; j++) {
 				dz_io_write(d[i], z[j].zone, z[j].name);
@@ -331,14 +420,14 @@ nor a date/time corresponding to the given input formats", inp);
 			for (size_t j = 0U; j < nz; j++) {
 				const zif_t zj = z[j].zone;
 				const char *zn = z[j].name;
-				struct zrng_s r;
+				struct zrng64_s r;
 
 				if (UNLIKELY(zj == NULL)) {
 					/* don't bother */
 					continue;
 				}
 				/* otherwise find the range */
-				r = zif_find_zrng(zj, di.sexy);
+				r = zif_find_zrng64(zj, di.sexy);
 
 				if (argi->next_flag) {
 					dz_write_nxtr(r, zj, zn);
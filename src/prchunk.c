@@ -51,14 +51,39 @@
 #include <string.h>
 #include <stdint.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
 #include <stdarg.h>
 #include <errno.h>
+#if defined HAVE_IMMINTRIN_H
+# include <immintrin.h>
+#endif	/* HAVE_IMMINTRIN_H */
 
 #include "nifty.h"
 #include "prchunk.h"
 
+/* -DPRCH_NO_SIMD leaves only the memchr() scanner, -DPRCH_NO_AVX2
+ * the SSE2 one too, so that test/ can check all of them */
+#if defined HAVE___M128I && defined __SSE2__ && !defined PRCH_NO_SIMD
+# define PRCH_SSE2
+#endif	/* __m128i && SSE2 */
+#if defined HAVE___M256I && defined __GNUC__ && \
+	(defined __x86_64__ || defined __i386__) && \
+	!defined PRCH_NO_SIMD && !defined PRCH_NO_AVX2
+/* AVX2 is compiled in regardless and used if the CPU says so */
+# define PRCH_AVX2
+#endif	/* __m256i && GCC && x86 */
+
+/* lines per fill */
 #define MAX_NLINES	(16384)
-#define MAX_LLEN	(1024)
+/* initial size of the line offset table, grows up to MAX_NLINES */
+#define INI_NLINES	(256U)
+/* initial read buffer size, doubles whenever a line doesn't fit */
+#define INI_BSZ		(1U << 20U)
+/* bytes per read() on pipes et al. */
+#define READ_SIZE	(1U << 20U)
+/* bytes before the last release point to release again, a page fault
+ * maps in neighbouring cached pages too, up to a whole (huge) folio */
+#define REL_SLACK	(1U << 21U)
 
 #if !defined MAP_ANONYMOUS && defined MAP_ANON
 # define MAP_ANONYMOUS	(MAP_ANON)
@@ -70,9 +95,6 @@
 # pragma warning(disable: 981)
 #endif	/* __INTEL_COMPILER */
 
-typedef uint32_t off32_t;
-typedef uint16_t off16_t;
-
 struct prch_ctx_s {
 	/* file descriptor */
 	int fd;
@@ -86,26 +108,43 @@ struct prch_ctx_s {
 	size_t bno;
 	/* last known offset */
 	size_t off;
-	/* offsets */
-	off32_t loff[MAX_NLINES];
-	off32_t cur_lno;
+	/* offsets, shifted left by 1, the lsb denotes \r\n termination */
+	size_t *loff;
+	size_t nloff;
+	uint32_t cur_lno;
 	/* delimiter offsets */
-	off16_t *soff;
+	uint32_t *soff;
+	size_t nsoff;
+
+	/* backing store, the read buffer or the file mapping */
+	char *mem;
+	size_t msz;
+	/* size of the mapping including the reserve page */
+	size_t mapsz;
+	/* start of the mapping's pages yet to be released */
+	char *rel;
+	size_t pgsz;
+	/* non-0 if MEM is a mapping of the input file */
+	unsigned int mmapp:1;
+	/* non-0 if the mapping has been confined by prchunk_window() */
+	unsigned int winp:1;
+	/* non-0 if the input is exhausted */
+	unsigned int eofp:1;
 };
 
 
 static inline void
-set_loff(prch_ctx_t ctx, uint32_t lno, off32_t off)
+set_loff(prch_ctx_t ctx, uint32_t lno, size_t off)
 {
 	ctx->loff[lno] = off;
 	ctx->loff[lno] <<= 1;
 	return;
 }
 
-static inline off32_t
+static inline size_t
 get_loff(prch_ctx_t ctx, uint32_t lno)
 {
-	off32_t res = ctx->loff[lno];
+	size_t res = ctx->loff[lno];
 	return res >> 1;
 }
 
@@ -135,156 +174,405 @@ get_llen(prch_ctx_t ctx, uint32_t lno)
 }
 
 
+
+#define MAP_MEM		(MAP_ANON | MAP_PRIVATE)
+#define PROT_MEM	(PROT_READ | PROT_WRITE)
+
 /* internal operations */
-FDEFU int
-prchunk_fill(prch_ctx_t ctx)
+static ssize_t
+prchunk_more(prch_ctx_t ctx)
 {
-/* this is a coroutine consisting of a line counter yielding the number of
- * lines read so far and a reader yielding a buffer fill and the number of
- * bytes read */
-#define CHUNK_SIZE	(4096)
-#define YIELD(x)	goto yield##x
-	char *off = ctx->buf + 0;
-	char *bno = ctx->buf + ctx->bno;
+/* make more bytes available behind CTX->buf + CTX->bno, return the
+ * number of new bytes, 0 on end of input and -1 if there's no room */
+	size_t room;
 	ssize_t nrd;
 
-	/* initial work, reset the line counters et al */
-	ctx->tot_lno = 0;
-	/* we just memcpy() the left over stuff to the front and restart
-	 * from there, someone left us a note in __ctx with the left
-	 * over offset */
-	/* normally we'd use memmove() but we know there's little chance
-	 * for overlapping regions */
-	if (UNLIKELY(ctx->bno == 0)) {
-		/* do nothing */
-		;
-	} else if (LIKELY(ctx->bno > ctx->off)) {
-		size_t rsz = ctx->bno - ctx->off;
-		/* move the top RSZ bytes to the beginning */
-		memcpy(ctx->buf, ctx->buf + ctx->off, rsz);
-		ctx->bno = rsz;
-		bno = ctx->buf + rsz;
-	} else if (UNLIKELY(ctx->bno == ctx->off)) {
-		/* what are the odds? just reset the counters */
-		ctx->bno = 0;
-		bno = ctx->buf;
-	} else {
-		/* the user didn't see the end of the file */
+	if (ctx->mmapp) {
+		/* the bytes are there already, just widen the window */
+		room = ctx->mem + ctx->msz - (ctx->buf + ctx->bno);
+		ctx->bno += room;
+		return room;
+	}
+	/* keep one byte for the terminator of an unterminated last line */
+	if ((room = ctx->msz - 1U - ctx->bno) == 0U) {
+		return -1;
+	} else if (room > READ_SIZE) {
+		room = READ_SIZE;
+	}
+	do {
+		nrd = read(ctx->fd, ctx->buf + ctx->bno, room);
+	} while (UNLIKELY(nrd < 0 && errno == EINTR));
+	if (UNLIKELY(nrd < 0)) {
+		/* treat like end of input */
+		return 0;
+	}
+	ctx->bno += nrd;
+	return nrd;
+}
+
+static int
+prchunk_grow(prch_ctx_t ctx)
+{
+/* double the read buffer */
+	size_t nusz = ctx->msz * 2U;
+	char *nu;
+
+	if (UNLIKELY(ctx->mmapp || (nu = realloc(ctx->mem, nusz)) == NULL)) {
+		return -1;
+	}
+	ctx->buf = nu + (ctx->buf - ctx->mem);
+	ctx->mem = nu;
+	ctx->msz = nusz;
+	return 0;
+}
+
+static int
+prchunk_grow_loff(prch_ctx_t ctx)
+{
+	size_t nusz = ctx->nloff * 2U;
+	size_t *nu;
+
+	if (UNLIKELY((nu = realloc(ctx->loff, nusz * sizeof(*nu))) == NULL)) {
 		return -1;
 	}
+	ctx->loff = nu;
+	ctx->nloff = nusz;
+	return 0;
+}
+
+static inline size_t
+max_nlines(prch_ctx_t ctx)
+{
+/* number of lines we can record in this fill */
+	return ctx->nloff < MAX_NLINES ? ctx->nloff : MAX_NLINES;
+}
+
+static inline char*
+prchunk_addln(prch_ctx_t ctx, char *off, char *p)
+{
+/* record the line from OFF terminated by the \n at P,
+ * return the beginning of the next line */
+	set_loff(ctx, ctx->tot_lno, p - ctx->buf);
+	if (UNLIKELY(p > off && p[-1] == '\r')) {
+		/* oh god, when is this nightmare gonna end */
+		p[-1] = '\0';
+		set_lftermd(ctx, ctx->tot_lno);
+	}
+	*p = '\0';
+	ctx->tot_lno++;
+	return ++p;
+}
 
-yield1:
-	/* read CHUNK_SIZE bytes */
-	bno += (nrd = read(ctx->fd, bno, CHUNK_SIZE));
-	/* if we came from yield2 then off == __ctx->bno, and if we
-	 * read 0 or less bytes then off >= __ctx->bno + nrd, so we
-	 * can simply use that compact expression if the buffer has no
-	 * more input.
-	 * On the contrary if we came from the outside, i.e. fill_buffer()
-	 * has been called, then off would be 0 and __ctx->bno would be
-	 * the buffer filled so far, if no more bytes could be read then
-	 * we'd proceed processing them (off < __ctx->bno + nrd */
-	if (UNLIKELY(!nrd && off < bno && ctx->cur_lno <= ctx->tot_lno)) {
-		/* last line then, unyielded :| */
-		set_loff(ctx, 0, bno - ctx->buf);
-		YIELD(4);
-	} else if (UNLIKELY(nrd <= 0 && off == ctx->buf)) {
-		/* special case, we worked our arses off and nothing's
-		 * in the pipe line so just fuck off here */
-		if (!ctx->bno) {
-			return -1;
+/* the scanners record all lines in [OFF, EOB) up to CTX's capacity,
+ * lines start at OFF, the search starts at FROM, return the beginning
+ * of the first unrecorded line */
+static char*
+prchunk_scan_memchr(prch_ctx_t ctx, char *off, char *from, char *eob)
+{
+	const size_t max = max_nlines(ctx);
+
+	for (char *p; ctx->tot_lno < max &&
+		     (p = memchr(from, '\n', eob - from)) != NULL;) {
+		from = off = prchunk_addln(ctx, off, p);
+	}
+	return off;
+}
+
+#if defined PRCH_SSE2
+static char*
+prchunk_scan_sse2(prch_ctx_t ctx, char *off, char *eob)
+{
+	const size_t max = max_nlines(ctx);
+	const __m128i nl = _mm_set1_epi8('\n');
+	char *p;
+
+	for (p = off; p + sizeof(__m128i) <= eob; p += sizeof(__m128i)) {
+		__m128i x = _mm_loadu_si128((const void*)p);
+		unsigned int m = _mm_movemask_epi8(_mm_cmpeq_epi8(x, nl));
+
+		for (; m; m &= m - 1U) {
+			if (UNLIKELY(ctx->tot_lno >= max)) {
+				return off;
+			}
+			off = prchunk_addln(ctx, off, p + __builtin_ctz(m));
 		}
-		/* go to drain mode */
-		YIELD(2);
-	} else if (LIKELY(off < bno || off == ctx->buf)) {
-		YIELD(2);
-	}
-	/* proceed to exit */
-	YIELD(3);
-yield2:
-	while (off < bno) {
-		size_t rsz = bno - off;
-		char *p = memchr(off, '\n', rsz);
-		if (UNLIKELY(p == NULL)) {
-			if (LIKELY(nrd > 0)) {
-				break;
+	}
+	/* the tail */
+	return prchunk_scan_memchr(ctx, off, p, eob);
+}
+#endif	/* PRCH_SSE2 */
+
+#if defined PRCH_AVX2
+__attribute__((target("avx2"))) static char*
+prchunk_scan_avx2(prch_ctx_t ctx, char *off, char *eob)
+{
+	const size_t max = max_nlines(ctx);
+	const __m256i nl = _mm256_set1_epi8('\n');
+	char *p;
+
+	for (p = off; p + sizeof(__m256i) <= eob; p += sizeof(__m256i)) {
+		__m256i x = _mm256_loadu_si256((const void*)p);
+		unsigned int m = _mm256_movemask_epi8(_mm256_cmpeq_epi8(x, nl));
+
+		for (; m; m &= m - 1U) {
+			if (UNLIKELY(ctx->tot_lno >= max)) {
+				return off;
 			}
-			/* not concluded with \n, let's hope we're in drain mode */
-			return -1;
+			off = prchunk_addln(ctx, off, p + __builtin_ctz(m));
 		}
-		/* massage our status structures */
-		set_loff(ctx, ctx->tot_lno, p - ctx->buf);
-		if (UNLIKELY(p[-1] == '\r')) {
-			/* oh god, when is this nightmare gonna end */
-			p[-1] = '\0';
-			set_lftermd(ctx, ctx->tot_lno);
+	}
+	/* the tail */
+	return prchunk_scan_memchr(ctx, off, p, eob);
+}
+#endif	/* PRCH_AVX2 */
+
+static char*
+prchunk_scan(prch_ctx_t ctx, char *off, char *eob)
+{
+#if defined PRCH_AVX2
+	if (__builtin_cpu_supports("avx2")) {
+		return prchunk_scan_avx2(ctx, off, eob);
+	}
+#endif	/* PRCH_AVX2 */
+#if defined PRCH_SSE2
+	return prchunk_scan_sse2(ctx, off, eob);
+#else  /* !PRCH_SSE2 */
+	return prchunk_scan_memchr(ctx, off, off, eob);
+#endif	/* PRCH_SSE2 */
+}
+
+static void
+prchunk_release(prch_ctx_t ctx)
+{
+/* hand the mapping's pages behind CTX->buf back to the kernel, our
+ * \0s made private copies of them and they'd stay resident otherwise */
+#if defined MADV_DONTNEED
+	char *pg = ctx->mem + ((ctx->buf - ctx->mem) & ~(ctx->pgsz - 1U));
+
+	if (pg > ctx->rel) {
+		char *from = ctx->rel - ctx->mem > REL_SLACK
+			? ctx->rel - REL_SLACK : ctx->mem;
+
+		(void)madvise(from, pg - from, MADV_DONTNEED);
+		ctx->rel = pg;
+	}
+#endif	/* MADV_DONTNEED */
+	return;
+}
+
+static char*
+prchunk_unmap(prch_ctx_t ctx, char *off)
+{
+/* if the mapped file has grown since we mapped it, copy the bytes in
+ * the window to a read buffer and go on read()ing from where the
+ * mapping ended, return OFF relative to the new buffer or NULL */
+	struct stat st;
+	size_t nusz;
+	char *nu;
+
+	if (!ctx->mmapp || ctx->winp) {
+		return NULL;
+	} else if (fstat(ctx->fd, &st) < 0 || st.st_size <= (off_t)ctx->msz) {
+		return NULL;
+	}
+	/* keep one byte for the terminator, like prchunk_more() */
+	for (nusz = INI_BSZ; nusz <= ctx->bno; nusz *= 2U);
+	if (UNLIKELY((nu = malloc(nusz)) == NULL)) {
+		return NULL;
+	}
+	memcpy(nu, ctx->buf, ctx->bno);
+	off = nu + (off - ctx->buf);
+	munmap(ctx->mem, ctx->mapsz);
+	ctx->mem = ctx->buf = nu;
+	ctx->msz = nusz;
+	ctx->mmapp = 0U;
+	return off;
+}
+
+FDEFU int
+prchunk_fill(prch_ctx_t ctx)
+{
+/* yield up to MAX_NLINES lines, return -1 if there are none */
+	char *off;
+	char *eob;
+
+	/* get rid of the lines consumed last time */
+	if (ctx->mmapp) {
+		/* zero-copy, just slide the window */
+		ctx->buf += ctx->off;
+		ctx->bno -= ctx->off;
+		prchunk_release(ctx);
+	} else if (ctx->off) {
+		/* move the left over bytes to the front */
+		ctx->bno -= ctx->off;
+		memmove(ctx->buf, ctx->buf + ctx->off, ctx->bno);
+	}
+	ctx->off = 0U;
+	ctx->tot_lno = 0U;
+	ctx->cur_lno = 0U;
+
+	for (off = ctx->buf, eob = ctx->buf + ctx->bno;;) {
+		ssize_t nrd = 0;
+		char *nu;
+
+		/* bulk-find all lines we've got room for */
+		off = prchunk_scan(ctx, off, eob);
+		if (ctx->tot_lno >= MAX_NLINES) {
+			break;
+		} else if (UNLIKELY(ctx->tot_lno >= ctx->nloff)) {
+			if (prchunk_grow_loff(ctx) < 0) {
+				/* yield what we've got */
+				break;
+			}
+			continue;
+		} else if (!ctx->eofp && (nrd = prchunk_more(ctx)) > 0) {
+			eob = ctx->buf + ctx->bno;
+			continue;
+		} else if (!ctx->eofp && nrd < 0 && ctx->tot_lno) {
+			/* out of room, yield what we've got */
+			break;
+		} else if (!ctx->eofp && nrd < 0 && !prchunk_grow(ctx)) {
+			/* line didn't fit, buffer has been enlarged,
+			 * no lines yet so OFF was at the front */
+			off = ctx->buf;
+			eob = ctx->buf + ctx->bno;
+			continue;
+		} else if (!ctx->eofp && nrd == 0 &&
+			   (nu = prchunk_unmap(ctx, off)) != NULL) {
+			/* file has grown, e.g. a log being appended to */
+			off = nu;
+			eob = ctx->buf + ctx->bno;
+			continue;
+		} else if (!ctx->eofp && nrd == 0) {
+			ctx->eofp = 1U;
 		}
-		*p = '\0';
-		off = ++p;
-		/* count it as line and check if we need more */
-		if (++ctx->tot_lno >= MAX_NLINES) {
-			YIELD(3);
+		/* last line, possibly unterminated, possibly truncated */
+		if (off < eob) {
+			set_loff(ctx, ctx->tot_lno++, eob - ctx->buf);
+			*eob = '\0';
+			off = eob;
 		}
+		break;
 	}
-	YIELD(1);
-yield3:
-	/* need clean up, something like unread(),
-	 * in particular leave a note in __ctx with the left over offset */
-	ctx->cur_lno = 0;
-yield4:
 	ctx->off = off - ctx->buf;
-	ctx->bno = bno - ctx->buf;
-#undef YIELD
-#undef CHUNK_SIZE
+	return ctx->tot_lno ? 0 : -1;
+}
+
+static int
+prchunk_map(prch_ctx_t ctx)
+{
+/* map CTX->fd if it's a regular file, return 0 on success */
+	struct stat st;
+	off_t cur;
+	size_t pgsz;
+	char *m;
+
+	if (fstat(ctx->fd, &st) < 0 || !S_ISREG(st.st_mode)) {
+		return -1;
+	} else if ((cur = lseek(ctx->fd, 0, SEEK_CUR)) < 0) {
+		return -1;
+	} else if (st.st_size <= cur) {
+		return -1;
+	}
+	/* reserve a zero page past the end of the file so that an
+	 * unterminated last line can be \0-terminated in place */
+	pgsz = sysconf(_SC_PAGESIZE);
+	ctx->mapsz = ((size_t)st.st_size + pgsz) & ~(pgsz - 1U);
+	m = mmap(NULL, ctx->mapsz, PROT_MEM, MAP_MEM, -1, 0);
+	if (m == MAP_FAILED) {
+		return -1;
+	}
+	/* private mapping, our \0s mustn't end up in the file */
+	if (mmap(m, st.st_size, PROT_MEM, MAP_PRIVATE | MAP_FIXED,
+		 ctx->fd, 0) == MAP_FAILED) {
+		munmap(m, ctx->mapsz);
+		return -1;
+	}
+#if defined MADV_SEQUENTIAL
+	(void)madvise(m, ctx->mapsz, MADV_SEQUENTIAL);
+#endif	/* MADV_SEQUENTIAL */
+	/* the window ends at the file's end, not the reserve page's */
+	ctx->mem = m;
+	ctx->msz = st.st_size;
+	ctx->buf = m + cur;
+	ctx->rel = m;
+	ctx->pgsz = pgsz;
+	ctx->mmapp = 1U;
+	/* pretend we've read up to the mapping's end, should the file
+	 * grow in the meantime prchunk_unmap() reads on from there */
+	(void)lseek(ctx->fd, st.st_size, SEEK_SET);
 	return 0;
 }
 
-
+
 /* public operations */
 FDEFU prch_ctx_t
 init_prchunk(int fd)
 {
-#define MAP_MEM		(MAP_ANON | MAP_PRIVATE)
-#define PROT_MEM	(PROT_READ | PROT_WRITE)
-#define MAP_LEN		(MAX_NLINES * MAX_LLEN)
-	static struct prch_ctx_s __ctx;
+	prch_ctx_t ctx;
 
-	__ctx.buf = mmap(NULL, MAP_LEN, PROT_MEM, MAP_MEM, -1, 0);
-	if (__ctx.buf == MAP_FAILED) {
+	if (UNLIKELY((ctx = calloc(1, sizeof(*ctx))) == NULL)) {
 		return NULL;
 	}
+	ctx->fd = fd;
 
-	/* bit of space for the rechunker */
-	__ctx.soff = mmap(NULL, MAP_LEN, PROT_MEM, MAP_MEM, -1, 0);
-	if (__ctx.soff == MAP_FAILED) {
-		return NULL;
+	ctx->loff = malloc(INI_NLINES * sizeof(*ctx->loff));
+	if (UNLIKELY(ctx->loff == NULL)) {
+		goto free_ctx;
 	}
+	ctx->nloff = INI_NLINES;
 
-	if ((__ctx.fd = fd) > STDIN_FILENO) {
+	if (prchunk_map(ctx) == 0) {
+		/* zero-copy mode */
+		;
+	} else if ((ctx->mem = malloc(INI_BSZ)) == NULL) {
+		goto free_loff;
+	} else {
+		ctx->buf = ctx->mem;
+		ctx->msz = INI_BSZ;
+	}
+
+	if (fd > STDIN_FILENO && !ctx->mmapp) {
 #if defined POSIX_FADV_SEQUENTIAL
 		/* give advice about our read pattern */
 		int rc = posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
 
 		if (UNLIKELY(rc < 0)) {
-			munmap(__ctx.soff, MAP_LEN);
-			return NULL;
+			goto free_mem;
 		}
 #endif	/* POSIX_FADV_SEQUENTIAL */
 	}
-	return &__ctx;
+	return ctx;
+
+#if defined POSIX_FADV_SEQUENTIAL
+free_mem:
+	free(ctx->mem);
+#endif	/* POSIX_FADV_SEQUENTIAL */
+free_loff:
+	free(ctx->loff);
+free_ctx:
+	free(ctx);
+	return NULL;
 }
 
 FDEFU void
 free_prchunk(prch_ctx_t ctx)
 {
-	if (LIKELY(ctx->buf != NULL)) {
-		munmap(ctx->buf, MAP_LEN);
-		ctx->buf = NULL;
+	if (UNLIKELY(ctx == NULL)) {
+		return;
+	}
+	if (ctx->mmapp) {
+		munmap(ctx->mem, ctx->mapsz);
+	} else {
+		free(ctx->mem);
 	}
+	free(ctx->loff);
+	free(ctx->soff);
+	free(ctx);
 	return;
 }
 
-
+
 /* accessors/iterators/et al. */
 FDEFU size_t
 prchunk_get_nlines(prch_ctx_t ctx)
@@ -323,8 +611,38 @@ prchunk_reset(prch_ctx_t ctx)
 FDEFU int
 prchunk_haslinep(prch_ctx_t ctx)
 {
-/* the second condition is to allow unterminated last lines */
-	return ctx->cur_lno < ctx->tot_lno || ctx->cur_lno == 0U;
+	return ctx->cur_lno < ctx->tot_lno;
+}
+
+FDEFU char*
+prchunk_mem(prch_ctx_t ctx, size_t *len)
+{
+/* for mapped input return the bytes yet to be chunked, NULL otherwise,
+ * like lines these are private to the caller and may be scribbled on */
+	if (!ctx->mmapp) {
+		return NULL;
+	}
+	*len = ctx->msz - (ctx->buf + ctx->off - ctx->mem);
+	return ctx->buf + ctx->off;
+}
+
+FDEFU int
+prchunk_window(prch_ctx_t ctx, size_t beg, size_t end)
+{
+/* confine mapped input to bytes BEG through END of prchunk_mem(),
+ * END should be at a line boundary, before the first fill only */
+	size_t cur;
+
+	if (!ctx->mmapp || ctx->bno || beg > end) {
+		return -1;
+	} else if (end > ctx->msz - (cur = ctx->buf + ctx->off - ctx->mem)) {
+		return -1;
+	}
+	ctx->buf += ctx->off + beg;
+	ctx->off = 0U;
+	ctx->msz = cur + end;
+	ctx->winp = 1U;
+	return 0;
 }
 
 
@@ -344,11 +662,15 @@ prchunk_get_ncols(prch_ctx_t ctx)
 static inline void
 set_col_off(prch_ctx_t ctx, size_t lno, size_t cno, size_t off)
 {
-	ctx->soff[lno * prchunk_get_ncols(ctx) + cno] = (off16_t)off;
+	if (UNLIKELY(cno >= prchunk_get_ncols(ctx))) {
+		/* excess columns are ignored */
+		return;
+	}
+	ctx->soff[lno * prchunk_get_ncols(ctx) + cno] = (uint32_t)off;
 	return;
 }
 
-static inline off16_t
+static inline uint32_t
 get_col_off(prch_ctx_t ctx, size_t lno, size_t cno)
 {
 	return ctx->soff[lno * prchunk_get_ncols(ctx) + cno];
@@ -357,7 +679,7 @@ get_col_off(prch_ctx_t ctx, size_t lno, size_t cno)
 /* rechunker, chop the lines into smaller bits
  * Strategy is to go over all lines in the current chunk and
  * memchr() for the delimiter DELIM.
- * Store the offsets into __ctx->soff and bugger off leaving a \0
+ * Store the offsets into ctx->soff and bugger off leaving a \0
  * where the delimiter was. */
 FDEFU void
 prchunk_rechunk(prch_ctx_t ctx, char dlm, int ncols)
@@ -372,6 +694,17 @@ prchunk_rechunk(prch_ctx_t ctx, char dlm, int ncols)
 	char *bno = ctx->buf + ctx->off;
 	size_t rsz;
 
+	/* bit of space for the rechunker */
+	if ((rsz = (size_t)ctx->tot_lno * ncols) > ctx->nsoff) {
+		uint32_t *nu = realloc(ctx->soff, rsz * sizeof(*nu));
+
+		if (UNLIKELY(nu == NULL)) {
+			set_ncols(ctx, 0U);
+			return;
+		}
+		ctx->soff = nu;
+		ctx->nsoff = rsz;
+	}
 	set_ncols(ctx, ncols);
 	off = line = ctx->buf;
 	rsz = bno - off;
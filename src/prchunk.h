@@ -48,7 +48,7 @@
 
 typedef struct prch_ctx_s *prch_ctx_t;
 
-/* non-reentrant! */
+/* one independent context per reader */
 FDECL prch_ctx_t init_prchunk(int fd);
 FDECL void free_prchunk(prch_ctx_t);
 
@@ -62,6 +62,10 @@ FDECL size_t prchunk_getline(prch_ctx_t ctx, char **p);
 FDECL void prchunk_reset(prch_ctx_t ctx);
 FDECL int prchunk_haslinep(prch_ctx_t ctx);
 
+/* random access to mapped input */
+FDECL char *prchunk_mem(prch_ctx_t ctx, size_t *len);
+FDECL int prchunk_window(prch_ctx_t ctx, size_t beg, size_t end);
+
 FDECL void prchunk_rechunk(prch_ctx_t ctx, char delim, int ncols);
 FDECL size_t prchunk_getcolno(prch_ctx_t ctx, char **p, int lno, int cno);
 
@@ -68,8 +68,8 @@ static void
 prnt_line(const char *ofmt, struct tm *tm)
 {
 	char res[256];
-	strftime(res, sizeof(res), ofmt, tm);
-	fputs(res, stdout);
+	size_t n = strftime(res, sizeof(res), ofmt, tm);
+	dt_io_owrite(res, n);
 	return;
 }
 
@@ -0,0 +1,174 @@
+/* alist checks, growth and rehashing of the key index, overwrites,
+ * colliding keys, insertion order iteration and failing allocations
+ * alist.c is built right into this so we can get at __hash() and
+ * make realloc() and calloc() fail on demand */
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static unsigned int nfail_realloc;
+static unsigned int nfail_calloc;
+
+static void*
+__realloc(void *p, size_t z)
+{
+	if (nfail_realloc) {
+		nfail_realloc--;
+		return NULL;
+	}
+	return realloc(p, z);
+}
+
+static void*
+__calloc(size_t n, size_t z)
+{
+	if (nfail_calloc) {
+		nfail_calloc--;
+		return NULL;
+	}
+	return calloc(n, z);
+}
+
+#define realloc	__realloc
+#define calloc	__calloc
+#include "alist.c"
+#undef realloc
+#undef calloc
+
+#define NKEYS	(2000U)
+
+static char keys[NKEYS][24U];
+static int vals[NKEYS];
+
+static int
+chk_order(alist_t al, size_t n, const char *what)
+{
+/* alist_next() must yield the first N keys in insertion order */
+	size_t i = 0U;
+
+	for (acons_t c; (c = alist_next(al)).key != NULL; i++) {
+		if (i >= n || strcmp(c.key, keys[i]) || c.val != vals + i) {
+			fprintf(stderr, "%s: entry %zu is %s, should be %s\n",
+				what, i, c.key, i < n ? keys[i] : "nothing");
+			return 1;
+		}
+	}
+	if (i != n) {
+		fprintf(stderr, "%s: %zu entries, should be %zu\n",
+			what, i, n);
+		return 1;
+	}
+	return 0;
+}
+
+static int
+chk_assoc(alist_t al, size_t n, const char *what)
+{
+/* the first N keys must map to their values */
+	for (size_t i = 0U; i < n; i++) {
+		if (alist_assoc(al, keys[i]) != vals + i) {
+			fprintf(stderr, "%s: %s not found\n", what, keys[i]);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+int
+main(void)
+{
+	struct alist_s al = {NULL};
+	int res = 0;
+
+	/* keys of all sorts of lengths */
+	for (size_t i = 0U; i < NKEYS; i++) {
+		snprintf(keys[i], sizeof(keys[i]), "%zu%.*s", i,
+			 (int)(i % 20U), "..................");
+	}
+
+	/* past the initial 16 slots, with a rehash at every doubling,
+	 * and checking everything inserted so far after each one */
+	for (size_t i = 0U; i < NKEYS; i++) {
+		size_t nsl = al.hnsl;
+
+		alist_put(&al, keys[i], vals + i);
+		if (al.hnsl != nsl && chk_assoc(&al, i + 1U, "rehash")) {
+			res = 1;
+			break;
+		}
+	}
+	printf("%zu keys, %zu slots\n", al.nkey, al.hnsl);
+	res |= chk_assoc(&al, NKEYS, "put");
+	res |= chk_order(&al, NKEYS, "put");
+	if (alist_assoc(&al, "not a key") != NULL) {
+		fputs("found a key that isn't there\n", stderr);
+		res = 1;
+	}
+
+	/* overwrites keep the position and don't add entries */
+	for (size_t i = 0U; i < NKEYS; i += 3U) {
+		alist_set(&al, keys[i], vals + NKEYS - 1U - i);
+	}
+	for (size_t i = 0U; i < NKEYS; i += 3U) {
+		alist_set(&al, keys[i], vals + i);
+	}
+	res |= chk_assoc(&al, NKEYS, "set");
+	res |= chk_order(&al, NKEYS, "set");
+	free_alist(&al);
+
+	/* keys sharing a home slot in the 16 slot index, the later
+	 * ones have to probe past the earlier ones */
+	with (size_t n = 0U, h0 = __hash(keys[0U]) & 15U) {
+		for (size_t i = 0U; i < NKEYS && n < 6U; i++) {
+			if ((__hash(keys[i]) & 15U) == h0) {
+				memcpy(keys[n], keys[i], sizeof(*keys));
+				n++;
+			}
+		}
+		for (size_t i = 0U; i < n; i++) {
+			alist_set(&al, keys[i], vals + i);
+		}
+		for (size_t i = 0U; i < n; i++) {
+			alist_set(&al, keys[i], vals + i);
+		}
+		if (al.hnsl != 16U) {
+			fputs("collisions: index has grown\n", stderr);
+			res = 1;
+		}
+		res |= chk_assoc(&al, n, "collisions");
+		res |= chk_order(&al, n, "collisions");
+	}
+	free_alist(&al);
+
+	/* a key longer than twice the initial buffer */
+	with (char k[300U]) {
+		memset(k, 'k', sizeof(k) - 1U);
+		k[sizeof(k) - 1U] = '\0';
+		alist_put(&al, keys[0U], vals + 0U);
+		alist_put(&al, k, vals + 1U);
+		if (alist_assoc(&al, k) != vals + 1U ||
+		    alist_assoc(&al, keys[0U]) != vals + 0U) {
+			fputs("long key: not found\n", stderr);
+			res = 1;
+		}
+	}
+	free_alist(&al);
+
+	/* failing to grow the buffer or the index loses the key
+	 * but leaves the alist usable */
+	nfail_realloc = 1U;
+	alist_put(&al, keys[0U], vals + 0U);
+	nfail_calloc = 1U;
+	alist_put(&al, keys[0U], vals + 0U);
+	alist_put(&al, keys[0U], vals + 0U);
+	alist_put(&al, keys[1U], vals + 1U);
+	res |= chk_assoc(&al, 2U, "failures");
+	res |= chk_order(&al, 2U, "failures");
+	free_alist(&al);
+	return res;
+}
+
+/* alist-1.c ends here */
@@ -4,6 +4,9 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <inttypes.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
 #include "dt-core.h"
 
 #define CHECK_RES(rc, pred, args...)		\
@@ -166,6 +169,58 @@ test_dt_no_fmt(void)
 	return res;
 }
 
+static int
+test_d_only_page_end(void)
+{
+/* a date right before an unmapped page, nothing past its end may be read */
+	static const char str[] = "2012-03-28";
+	const size_t pgsz = sysconf(_SC_PAGESIZE);
+	struct dt_dt_s d;
+	char *pg;
+	int res = 0;
+
+	fprintf(stderr, "testing %s at the end of a page ...\n", str);
+	pg = mmap(NULL, 2U * pgsz, PROT_READ | PROT_WRITE,
+		  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (pg == MAP_FAILED) {
+		fputs("  CANNOT MAP PAGES\n", stderr);
+		return 1;
+	} else if (mprotect(pg + pgsz, pgsz, PROT_NONE) < 0) {
+		fputs("  CANNOT PROTECT PAGE\n", stderr);
+		munmap(pg, 2U * pgsz);
+		return 1;
+	}
+	memcpy(pg + pgsz - sizeof(str), str, sizeof(str));
+	d = dt_strpdt(pg + pgsz - sizeof(str), NULL, NULL);
+
+	CHECK(!dt_sandwich_only_d_p(d), "  TYPE is not a d-only\n");
+	CHECK(d.d.ymd.y != 2012 || d.d.ymd.m != 3 || d.d.ymd.d != 28,
+	      "  DATE %u-%u-%u ... should be 2012-3-28\n",
+	      (unsigned int)d.d.ymd.y,
+	      (unsigned int)d.d.ymd.m,
+	      (unsigned int)d.d.ymd.d);
+	munmap(pg, 2U * pgsz);
+	return res;
+}
+
+static int
+test_d_only_stale(void)
+{
+/* a date followed by what looks like a time but after the string's end */
+	static const char str[32U] = "2012-03-28\0T12:34:56";
+	struct dt_dt_s d;
+	int res = 0;
+
+	fprintf(stderr, "testing %s with a stale time behind it ...\n", str);
+	d = dt_strpdt(str, NULL, NULL);
+
+	CHECK(!dt_sandwich_only_d_p(d), "  TYPE is not a d-only\n");
+	CHECK(d.t.u,
+	      "  TIME COMPONENT NOT NAUGHT %" PRIu64 "\n",
+	      (uint64_t)d.t.u);
+	return res;
+}
+
 int
 main(void)
 {
@@ -183,6 +238,14 @@ main(void)
 		res = 1;
 	}
 
+	if (test_d_only_page_end() != 0) {
+		res = 1;
+	}
+
+	if (test_d_only_stale() != 0) {
+		res = 1;
+	}
+
 	return res;
 }
 
@@ -0,0 +1,50 @@
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include "leaps.h"
+#include "leap-seconds.h"
+
+static int
+chk(int64_t t)
+{
+	int32_t t32 = t < INT32_MIN ? INT32_MIN : t > INT32_MAX ? INT32_MAX : t;
+	zidx_t ref = leaps_before_si32(leaps_s, nleaps, t32);
+	zidx_t res = leaps_sidx_si64(leaps_sidx, nleaps_sidx, t);
+
+	if (res != ref) {
+		fprintf(stderr, "%" PRIi64 ": index %zu ... should be %zu\n",
+			t, res, ref);
+		return 1;
+	}
+	return 0;
+}
+
+int
+main(void)
+{
+	int res = 0;
+
+	/* around every transition */
+	for (size_t i = 1U; i < nleaps - 1U; i++) {
+		for (int64_t d = -2; d <= 2; d++) {
+			res |= chk(leaps_s[i] + d);
+		}
+	}
+	/* bucket boundaries */
+	for (int64_t t = 0; t <= INT32_MAX; t += 1 << LEAPS_SIDX_SHIFT) {
+		res |= chk(t - 1);
+		res |= chk(t);
+	}
+	/* and the far ends */
+	res |= chk(-1);
+	res |= chk(INT32_MIN + 1LL);
+	res |= chk(INT32_MAX);
+	res |= chk(INT32_MAX + 1LL);
+	res |= chk(INT64_MAX);
+	return res;
+}
+
+/* leaps-1.c ends here */
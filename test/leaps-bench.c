@@ -0,0 +1,88 @@
+/* measure leap second lookups and TAI/GPS conversions
+ * usage: leaps-bench [N]
+ * converts N (default 10000000) stamps spread over 1970 to 2030,
+ * once using the bisection over leaps_s and once using leaps_sidx,
+ * then through the batch conversion for TAI and GPS */
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include "leaps.h"
+#include "leap-seconds.h"
+#include "tzraw.h"
+
+static const char *const zns[] = {"TAI", "GPS"};
+
+static double
+__now(void)
+{
+	struct timespec tsp;
+
+	clock_gettime(CLOCK_MONOTONIC, &tsp);
+	return (double)tsp.tv_sec + (double)tsp.tv_nsec * 1e-9;
+}
+
+static void
+__report(const char *what, double lap, size_t n, int64_t chk)
+{
+	printf("%-8s %6.2fns/stamp  (%lld)\n",
+	       what, lap / (double)n * 1e9, (long long int)chk);
+	return;
+}
+
+int
+main(int argc, char *argv[])
+{
+	size_t n = 10000000U;
+	int64_t *in, *out;
+	double beg;
+	int64_t s;
+
+	if (argc > 1) {
+		n = strtoul(argv[1U], NULL, 10);
+	}
+	if ((in = malloc(n * sizeof(*in))) == NULL ||
+	    (out = malloc(n * sizeof(*out))) == NULL) {
+		return 1;
+	}
+	/* a stream of ticks with the occasional jump */
+	for (size_t i = 0U; i < n; i++) {
+		in[i] = (int64_t)((i * 2654435761U) % 1893456000U);
+		out[i] = 0;
+	}
+
+	beg = __now();
+	s = 0;
+	for (size_t i = 0U; i < n; i++) {
+		int32_t t = in[i];
+		s += leaps_corr[leaps_before_si32(leaps_s, nleaps, t)];
+	}
+	__report("bisect", __now() - beg, n, s);
+
+	beg = __now();
+	s = 0;
+	for (size_t i = 0U; i < n; i++) {
+		s += leaps_corr[leaps_sidx_si64(leaps_sidx, nleaps_sidx, in[i])];
+	}
+	__report("sidx", __now() - beg, n, s);
+
+	for (size_t k = 0U; k < sizeof(zns) / sizeof(*zns); k++) {
+		zif_t z;
+
+		if ((z = zif_open(zns[k])) == NULL) {
+			continue;
+		}
+		beg = __now();
+		zif_local_time_v(z, in, out, n);
+		__report(zns[k], __now() - beg, n, out[n / 2U]);
+		zif_close(z);
+	}
+	free(in);
+	free(out);
+	return 0;
+}
+
+/* leaps-bench.c ends here */
@@ -0,0 +1,101 @@
+/* check that the locale file is only read once names are needed
+ * numeric parsing and formatting must leave the name tables alone,
+ * then several threads ask for month names at the same time and
+ * must all see the locale's */
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdio.h>
+#include <string.h>
+#if defined HAVE_PTHREAD_H
+# include <pthread.h>
+#endif	/* HAVE_PTHREAD_H */
+#include "date-core.h"
+#include "dt-locale.h"
+
+#define NTHR	(8U)
+
+static int
+__names(void)
+{
+/* parse and print a month name, 0 if both come out German */
+	struct dt_d_s d = dt_strpd("4 März 2012", "%d %B %Y", NULL);
+	char buf[64U];
+
+	if (d.typ == DT_DUNK) {
+		return 1;
+	}
+	dt_strfd(buf, sizeof(buf), "%B %b", d);
+	return strcmp(buf, "März Mär") != 0;
+}
+
+#if defined HAVE_PTHREAD_H
+static void*
+__thr(void *arg)
+{
+	*(int*)arg = __names();
+	return NULL;
+}
+#endif	/* HAVE_PTHREAD_H */
+
+int
+main(void)
+{
+	const char **il, **fl;
+	int res = 0;
+
+	setilocale("de_DE");
+	setflocale("de_DE");
+	il = dut_long_mon;
+	fl = duf_long_mon;
+
+	/* numbers only, no names wanted */
+	{
+		struct dt_d_s d = dt_strpd("2012-03-04", "%F", NULL);
+		char buf[64U];
+
+		dt_strfd(buf, sizeof(buf), "%F %d/%m/%Y %j", d);
+		if (strcmp(buf, "2012-03-04 04/03/2012 064")) {
+			fprintf(stderr, "numeric formatting gave `%s'\n", buf);
+			res = 1;
+		}
+	}
+	if (dut_long_mon != il || duf_long_mon != fl) {
+		fputs("locale loaded without names being used\n", stderr);
+		res = 1;
+	}
+
+#if defined HAVE_PTHREAD_H
+	{
+		pthread_t thr[NTHR];
+		int thr_res[NTHR];
+		int joinp[NTHR];
+
+		for (size_t i = 0U; i < NTHR; i++) {
+			joinp[i] = !pthread_create(
+				thr + i, NULL, __thr, thr_res + i);
+			if (!joinp[i]) {
+				thr_res[i] = __names();
+			}
+		}
+		for (size_t i = 0U; i < NTHR; i++) {
+			if (joinp[i]) {
+				pthread_join(thr[i], NULL);
+			}
+			if (thr_res[i]) {
+				fprintf(stderr, "thread %zu saw no names\n", i);
+				res = 1;
+			}
+		}
+	}
+#else  /* !HAVE_PTHREAD_H */
+	res |= __names();
+#endif	/* HAVE_PTHREAD_H */
+	if (dut_long_mon == il || duf_long_mon == fl) {
+		fputs("locale not loaded\n", stderr);
+		res = 1;
+	}
+	return res;
+}
+
+/* locale-1.c ends here */
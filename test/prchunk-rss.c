@@ -0,0 +1,125 @@
+/* check that the memory prchunk needs for mapped input tracks its
+ * working set rather than the size of the file
+ * chunks a 4MB and a 64MB file in a child each and compares the
+ * children's peak resident set sizes */
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "prchunk.h"
+
+#define SMALL	(4U << 20U)
+#define LARGE	(64U << 20U)
+
+static int
+__grow(int fd, size_t tgt)
+{
+/* append lines to FD until it holds TGT bytes */
+	static const char ln[] =
+		"2012-03-01 12:34:56 some payload to make it a line\n";
+	static char blk[(sizeof(ln) - 1U) << 10U];
+	off_t cur;
+
+	for (size_t i = 0U; i < sizeof(blk); i += sizeof(ln) - 1U) {
+		memcpy(blk + i, ln, sizeof(ln) - 1U);
+	}
+	if ((cur = lseek(fd, 0, SEEK_END)) < 0) {
+		return -1;
+	}
+	for (size_t n = cur; n < tgt; n += sizeof(blk)) {
+		if (write(fd, blk, sizeof(blk)) != (ssize_t)sizeof(blk)) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static int
+__chunk(const char *fn)
+{
+/* chunk FN like the tools do, looking at every byte of every line */
+	prch_ctx_t pctx;
+	unsigned int sum = 0U;
+	int fd;
+
+	if ((fd = open(fn, O_RDONLY)) < 0) {
+		return 1;
+	} else if ((pctx = init_prchunk(fd)) == NULL) {
+		return 1;
+	}
+	while (prchunk_fill(pctx) >= 0) {
+		for (char *line; prchunk_haslinep(pctx);) {
+			size_t llen = prchunk_getline(pctx, &line);
+
+			for (size_t i = 0U; i < llen; i++) {
+				sum += (unsigned char)line[i];
+			}
+		}
+	}
+	free_prchunk(pctx);
+	return !sum;
+}
+
+static long int
+__peak(const char *fn)
+{
+/* return the peak RSS of a child chunking FN */
+	struct rusage ru;
+	pid_t p;
+	int st;
+
+	switch ((p = fork())) {
+	case -1:
+		return -1;
+	case 0:
+		_exit(__chunk(fn));
+	default:
+		break;
+	}
+	if (wait4(p, &st, 0, &ru) < 0 || !WIFEXITED(st) || WEXITSTATUS(st)) {
+		return -1;
+	}
+	return ru.ru_maxrss;
+}
+
+int
+main(void)
+{
+	char fn[] = "prchunk-rss.XXXXXX";
+	long int small, large;
+	int res = 0;
+	int fd;
+
+#if !defined MADV_DONTNEED
+	/* pages can't be handed back */
+	return 77;
+#endif	/* !MADV_DONTNEED */
+	if ((fd = mkstemp(fn)) < 0) {
+		perror("cannot create test file");
+		return 1;
+	}
+	if (__grow(fd, SMALL) < 0 || (small = __peak(fn)) < 0) {
+		fputs("cannot chunk small file\n", stderr);
+		res = 1;
+	} else if (__grow(fd, LARGE) < 0 || (large = __peak(fn)) < 0) {
+		fputs("cannot chunk large file\n", stderr);
+		res = 1;
+	} else {
+		printf("peak RSS %ld for %uMB, %ld for %uMB\n",
+		       small, SMALL >> 20U, large, LARGE >> 20U);
+		/* sixteen times the input, allow for half as much again */
+		res = 2 * large > 3 * small;
+	}
+	close(fd);
+	unlink(fn);
+	return res;
+}
+
+/* prchunk-rss.c ends here */
@@ -0,0 +1,217 @@
+/* check prchunk's line scanners against a plain line splitter
+ * prchunk.c is built right into this, with -DPRCH_NO_AVX2 or
+ * -DPRCH_NO_SIMD the SSE2 and the memchr() scanners get their turn
+ * inputs are chunked off a mapped file and off a pipe and cover
+ * lines ending on and around the 16 and 32 byte block edges, \r\n
+ * pairs split across them, unterminated last lines and inputs of
+ * more lines than fit into one fill */
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include "prchunk.c"
+
+struct buf_s {
+	char *s;
+	size_t n;
+	size_t z;
+};
+
+static void
+__add(struct buf_s *b, const char *s, size_t n)
+{
+	if (b->n + n > b->z) {
+		do {
+			b->z = b->z ? b->z * 2U : 256U;
+		} while (b->z < b->n + n);
+		b->s = realloc(b->s, b->z);
+	}
+	memcpy(b->s + b->n, s, n);
+	b->n += n;
+	return;
+}
+
+static void
+__rep(struct buf_s *b, char c, size_t n)
+{
+	while (n--) {
+		__add(b, &c, 1U);
+	}
+	return;
+}
+
+static int
+__open(const struct buf_s *b, int pipep)
+{
+/* return a descriptor to read B from, a file or a pipe */
+	char fn[] = "prchunk-scan.XXXXXX";
+	int fd[2U];
+
+	if (!pipep) {
+		if ((*fd = mkstemp(fn)) < 0) {
+			return -1;
+		}
+		unlink(fn);
+		if (write(*fd, b->s, b->n) != (ssize_t)b->n) {
+			close(*fd);
+			return -1;
+		}
+		lseek(*fd, 0, SEEK_SET);
+		return *fd;
+	} else if (pipe(fd) < 0) {
+		return -1;
+	}
+	switch (fork()) {
+	case -1:
+		return -1;
+	case 0:
+		close(fd[0U]);
+		_exit(write(fd[1U], b->s, b->n) != (ssize_t)b->n);
+	default:
+		close(fd[1U]);
+		break;
+	}
+	return fd[0U];
+}
+
+static int
+__check(const char *what, const struct buf_s *b, int pipep)
+{
+/* chunk B and compare with splitting it by hand */
+	const char *s = b->s;
+	const char *const eob = b->s + b->n;
+	prch_ctx_t pctx;
+	size_t lno = 0U;
+	int res = 0;
+	int fd;
+
+	if ((fd = __open(b, pipep)) < 0) {
+		perror(what);
+		return 1;
+	} else if ((pctx = init_prchunk(fd)) == NULL) {
+		fprintf(stderr, "%s: cannot chunk\n", what);
+		close(fd);
+		return 1;
+	}
+	while (!res && prchunk_fill(pctx) >= 0) {
+		for (char *line; prchunk_haslinep(pctx); lno++) {
+			size_t llen = prchunk_getline(pctx, &line);
+			const char *e = memchr(s, '\n', eob - s);
+			size_t elen;
+
+			e = e ? e : eob;
+			elen = e - s;
+
+			if (e < eob && elen && e[-1] == '\r') {
+				elen--;
+			}
+			if (s >= eob || llen != elen ||
+			    memcmp(line, s, llen) || line[llen]) {
+				fprintf(stderr, "\
+%s (%s): line %zu is `%.*s' (%zu), should be `%.*s' (%zu)\n",
+					what, pipep ? "pipe" : "file", lno,
+					(int)llen, line, llen,
+					(int)elen, s, elen);
+				res = 1;
+				break;
+			}
+			s = e + (e < eob);
+		}
+	}
+	if (!res && s < eob) {
+		fprintf(stderr, "%s (%s): lines missing from line %zu on\n",
+			what, pipep ? "pipe" : "file", lno);
+		res = 1;
+	}
+	free_prchunk(pctx);
+	close(fd);
+	if (pipep) {
+		(void)wait(NULL);
+	}
+	return res;
+}
+
+static int
+__check_both(const char *what, const struct buf_s *b)
+{
+	return __check(what, b, 0) | __check(what, b, 1);
+}
+
+int
+main(void)
+{
+	struct buf_s b = {NULL};
+	char what[64U];
+	int res = 0;
+
+#if defined PRCH_AVX2
+	puts(__builtin_cpu_supports("avx2") ? "scanner avx2" : "scanner sse2");
+#elif defined PRCH_SSE2
+	puts("scanner sse2");
+#else  /* !PRCH_SSE2 */
+	puts("scanner memchr");
+#endif	/* PRCH_AVX2 */
+
+	/* a line of every length up to 3 blocks and then some, followed
+	 * by a short \r\n terminated one, an empty one and one that
+	 * fills up to the next block edge, with and without final \n */
+	for (size_t k = 0U; k < 100U; k++) {
+		for (int termp = 0; termp < 2; termp++) {
+			b.n = 0U;
+			__rep(&b, 'x', k);
+			__add(&b, "\n", 1U);
+			__rep(&b, 'y', k % 37U);
+			__add(&b, "\r\n\n", 3U);
+			__rep(&b, 'z', 33U - k % 33U);
+			if (termp) {
+				__add(&b, "\n", 1U);
+			}
+			snprintf(what, sizeof(what), "length %zu%s",
+				 k, termp ? "" : ", unterminated");
+			res |= __check_both(what, &b);
+		}
+	}
+
+	/* lines of E bytes, shifted by K so that with K = 0 the \r ends
+	 * one block and the \n starts the next, and a lone \r at the end */
+	for (size_t e = 16U; e <= 64U; e *= 2U) {
+		for (size_t k = 0U; k < 4U; k++) {
+			b.n = 0U;
+			__rep(&b, '`', e - 1U - k);
+			__add(&b, "\r\n", 2U);
+			for (size_t i = 1U; i < 8U; i++) {
+				__rep(&b, '`' + i, e - 2U);
+				__add(&b, "\r\n", 2U);
+			}
+			__rep(&b, 'q', k);
+			__add(&b, "\r", 1U);
+			snprintf(what, sizeof(what),
+				 "\\r\\n across %zu byte edges, shift %zu",
+				 e, k);
+			res |= __check_both(what, &b);
+		}
+	}
+
+	/* more lines than one fill takes, of ragged lengths */
+	b.n = 0U;
+	for (size_t i = 0U; i < 3U * MAX_NLINES + 5U; i++) {
+		__rep(&b, '0' + i % 10U, (i * 7U) % 53U);
+		if (i % 3U) {
+			__add(&b, "\n", 1U);
+		} else {
+			__add(&b, "\r\n", 2U);
+		}
+	}
+	__rep(&b, 'e', 17U);
+	res |= __check_both("many lines", &b);
+
+	free(b.s);
+	return res;
+}
+
+/* prchunk-scan.c ends here */
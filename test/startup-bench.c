@@ -0,0 +1,85 @@
+/* measure the latency of one-shot invocations
+ * usage: startup-bench [-n N] TOOL [ARG]...
+ * runs TOOL N times (default 1000) with stdout going to /dev/null and
+ * reports the mean and the fastest wall clock time per invocation */
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/wait.h>
+
+static double
+__now(void)
+{
+	struct timespec tsp;
+
+	clock_gettime(CLOCK_MONOTONIC, &tsp);
+	return (double)tsp.tv_sec + (double)tsp.tv_nsec * 1e-9;
+}
+
+static int
+__run(char *const argv[])
+{
+	pid_t p;
+	int st;
+
+	switch ((p = fork())) {
+	case -1:
+		return -1;
+	case 0: {
+		int fd = open("/dev/null", O_WRONLY);
+
+		dup2(fd, STDOUT_FILENO);
+		execv(argv[0U], argv);
+		_exit(127);
+	}
+	default:
+		break;
+	}
+	if (waitpid(p, &st, 0) < 0 || !WIFEXITED(st) || WEXITSTATUS(st) == 127) {
+		return -1;
+	}
+	return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+	long int n = 1000;
+	double tot = 0.;
+	double min = 1e9;
+
+	if (argc > 2 && !strcmp(argv[1U], "-n")) {
+		n = strtol(argv[2U], NULL, 10);
+		argv += 2, argc -= 2;
+	}
+	if (argc < 2 || n <= 0) {
+		fputs("usage: startup-bench [-n N] TOOL [ARG]...\n", stderr);
+		return 1;
+	}
+
+	for (long int i = 0; i < n; i++) {
+		double beg = __now();
+		double lap;
+
+		if (__run(argv + 1) < 0) {
+			fprintf(stderr, "cannot run %s\n", argv[1U]);
+			return 1;
+		}
+		lap = __now() - beg;
+		tot += lap;
+		if (lap < min) {
+			min = lap;
+		}
+	}
+	printf("%ld runs  mean %.1fus  min %.1fus\n",
+	       n, tot / (double)n * 1e6, min * 1e6);
+	return 0;
+}
+
+/* startup-bench.c ends here */
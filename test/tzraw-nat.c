@@ -0,0 +1,142 @@
+/* check that native zone files with out-of-range indices are refused
+ * tzraw.c is built right into this so we know where things are in the
+ * image, a zone is written out, then one field at a time is corrupted
+ * and the result must not open */
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "tzraw.c"
+
+static char *img;
+static size_t imz;
+
+static int
+__try(const char *what, size_t off, const void *val, size_t vsz, bool okp)
+{
+/* write the image with VSZ bytes at OFF replaced by VAL, then open it,
+ * return 0 if that succeeds iff OKP */
+	char fn[] = "/tmp/tzraw-nat.XXXXXX";
+	char *buf = malloc(imz);
+	zif_t z;
+	int fd;
+
+	memcpy(buf, img, imz);
+	memcpy(buf + off, val, vsz);
+	if ((fd = mkstemp(fn)) < 0) {
+		perror("cannot create zone file");
+		free(buf);
+		return 1;
+	} else if (write(fd, buf, imz) != (ssize_t)imz) {
+		perror("cannot write zone file");
+		close(fd);
+		unlink(fn);
+		free(buf);
+		return 1;
+	}
+	close(fd);
+	free(buf);
+	z = zif_open(fn);
+	unlink(fn);
+	if ((z != NULL) != okp) {
+		fprintf(stderr, "%s: %s\n",
+			what, okp ? "refused" : "accepted");
+		zif_close(z);
+		return 1;
+	}
+	zif_close(z);
+	return 0;
+}
+
+#define TRY(what, off, val, okp)	\
+	__try(what, off, &(val), sizeof(val), okp)
+
+int
+main(void)
+{
+	char fn[] = "/tmp/tzraw-nat.XXXXXX";
+	const struct zif_s *z;
+	size_t ntr, nch;
+	size_t otys, otda, ozn, oidx;
+	int res = 0;
+	int fd;
+
+	if ((z = (const void*)zif_open("Europe/Berlin")) == NULL) {
+		/* no zoneinfo */
+		return 77;
+	} else if (z->idx == NULL) {
+		fputs("Europe/Berlin has no transition index\n", stderr);
+		return 1;
+	}
+	ntr = zif_ntrans(z);
+	nch = zif_nchars(z);
+	/* the image starts on a cache line, in the file as in memory */
+	otys = sizeof(struct znat_s) + ((char*)z->tys - (char*)z->hdr);
+	otda = sizeof(struct znat_s) + ((char*)z->tda - (char*)z->hdr);
+	ozn = sizeof(struct znat_s) + ((char*)z->zn - (char*)z->hdr);
+	oidx = sizeof(struct znat_s) + ((char*)z->idx - (char*)z->hdr);
+
+	if ((fd = mkstemp(fn)) < 0 || zif_write((zif_t)z, fd) < 0) {
+		perror("cannot write zone file");
+		return 1;
+	}
+	imz = lseek(fd, 0, SEEK_END);
+	img = malloc(imz);
+	if (pread(fd, img, imz, 0) != (ssize_t)imz) {
+		perror("cannot read zone file");
+		return 1;
+	}
+	close(fd);
+	unlink(fn);
+
+	/* the untouched file opens */
+	res |= TRY("untouched", 0U, *img, true);
+
+	/* types */
+	with (uint8_t ty = (uint8_t)zif_ntypes(z)) {
+		res |= TRY("type", otys + ntr - 1U, ty, false);
+	}
+	/* zone names */
+	with (uint8_t ab = (uint8_t)nch) {
+		res |= TRY("abbreviation",
+			   otda + offsetof(struct ztrdtl_s, abbr), ab, false);
+	}
+	with (char c = 'X') {
+		res |= TRY("unterminated names", ozn + nch - 1U, c, false);
+	}
+	/* the index parameters */
+	with (int64_t ib = z->ibase - 1) {
+		res |= TRY("index base", offsetof(struct znat_s, ibase),
+			   ib, false);
+	}
+	with (uint32_t sh = 0U) {
+		res |= TRY("index shift 0", offsetof(struct znat_s, ishft),
+			   sh, false);
+	}
+	with (uint32_t sh = 64U) {
+		res |= TRY("index shift 64", offsetof(struct znat_s, ishft),
+			   sh, false);
+	}
+	/* the buckets */
+	with (uint16_t b = (uint16_t)(ntr + 1U)) {
+		res |= TRY("bucket past the end",
+			   oidx + (ZIDX_NBKT - 1U) * sizeof(b), b, false);
+	}
+	with (uint16_t b = (uint16_t)(z->idx[ZIDX_NBKT / 2U + 1U] + 1U)) {
+		res |= TRY("decreasing buckets",
+			   oidx + ZIDX_NBKT / 2U * sizeof(b), b, false);
+	}
+	with (uint16_t b = (uint16_t)(ntr - 1U)) {
+		res |= TRY("sentinel", oidx + ZIDX_NBKT * sizeof(b), b, false);
+	}
+
+	free(img);
+	zif_close((zif_t)z);
+	return res;
+}
+
+/* tzraw-nat.c ends here */
@@ -0,0 +1,83 @@
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include "tzraw.h"
+
+#define NSTMP	(20000U)
+
+static const char *const zones[] = {
+	"Europe/Berlin",
+	"Australia/Sydney",
+	"America/St_Johns",
+	"TAI",
+};
+
+static int64_t in[NSTMP];
+static int64_t out[NSTMP];
+
+static int
+chk_zone(zif_t z, const char *zn)
+{
+	int res = 0;
+
+	zif_local_time_v(z, in, out, NSTMP);
+	for (size_t i = 0U; i < NSTMP; i++) {
+		int64_t ref = zif_local_time64(z, in[i]);
+
+		if (out[i] != ref) {
+			fprintf(stderr, "%s: local %" PRIi64 " -> %" PRIi64
+				" ... should be %" PRIi64 "\n",
+				zn, in[i], out[i], ref);
+			res = 1;
+			break;
+		}
+	}
+
+	zif_utc_time_v(z, in, out, NSTMP);
+	for (size_t i = 0U; i < NSTMP; i++) {
+		int64_t ref = zif_utc_time64(z, in[i]);
+
+		if (out[i] != ref) {
+			fprintf(stderr, "%s: utc %" PRIi64 " -> %" PRIi64
+				" ... should be %" PRIi64 "\n",
+				zn, in[i], out[i], ref);
+			res = 1;
+			break;
+		}
+	}
+	return res;
+}
+
+int
+main(void)
+{
+	int res = 0;
+	int nz = 0;
+
+	/* sorted, 1h apart, across the 2037 transition table end */
+	for (size_t i = 0U; i < NSTMP / 2U; i++) {
+		in[i] = 2114380800 + (int64_t)i * 3600 - NSTMP * 900;
+	}
+	/* and some jumping about, including pre-1970 */
+	for (size_t i = NSTMP / 2U; i < NSTMP; i++) {
+		in[i] = (int64_t)((i * 2654435761U) % 4000000000U) - 1000000000;
+	}
+
+	for (size_t i = 0U; i < sizeof(zones) / sizeof(*zones); i++) {
+		zif_t z;
+
+		if ((z = zif_open(zones[i])) == NULL) {
+			continue;
+		}
+		res |= chk_zone(z, zones[i]);
+		zif_close(z);
+		nz++;
+	}
+	/* no zoneinfo, no test */
+	return nz ? res : 77;
+}
+
+/* tzraw-vec.c ends here */